@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Compare snapshot streams of the same run with a reference stream.
+
+Used by simulationCases/runPrecision.sh to measure the accuracy of the
+single- and mixed-precision builds against the double-precision one.
+For the last frame which all the streams have in common (same
+iteration), and for each field, prints the relative L2 and maximum
+differences with the reference and the relative difference of the
+dominant wavenumber of the pattern (the spectral centroid, as in
+src-local/steady.h), which is what matters when only the morphology is
+needed.
+
+Usage:
+
+    python3 postProcess/compare_precision.py <reference.bin> <name>=<other.bin>...
+"""
+
+import sys
+
+import numpy as np
+
+from snapshots import read_snapshots, uniform
+
+
+def _frames(path):
+    frames = {}
+    for frame in read_snapshots(path):
+        frame["fields"] = uniform(frame)
+        frames[frame["i"]] = frame
+    return frames
+
+
+def wavenumber(field, L0):
+    """Spectral centroid of a field sampled on a uniform grid of size L0."""
+    n = field.shape[0]
+    power = np.abs(np.fft.fft2(field - field.mean())) ** 2
+    k = 2 * np.pi * np.fft.fftfreq(n, d=L0 / n)
+    k2 = k[None, :] ** 2 + k[:, None] ** 2
+    total = power.sum()
+    return float(np.sqrt((k2 * power).sum() / total)) if total > 0 else 0.0
+
+
+def main(argv):
+    if len(argv) < 3:
+        print(__doc__.split("Usage:")[1].strip(), file=sys.stderr)
+        return 1
+    reference = _frames(argv[1])
+    others = []
+    for arg in argv[2:]:
+        name, _, path = arg.partition("=")
+        others.append((name, _frames(path)))
+
+    common = set(reference)
+    for _, frames in others:
+        common &= set(frames)
+    if not common:
+        print("No frame common to all the streams", file=sys.stderr)
+        return 1
+    i = max(common)
+    ref = reference[i]
+    print(f"# i={i} t={ref['t']:g} n={ref['n']}")
+    print("precision\tfield\trel_l2\trel_max\trel_wavenumber")
+    for name, frames in others:
+        frame = frames[i]
+        for field, r in ref["fields"].items():
+            f = np.asarray(frame["fields"][field], dtype=float)
+            r = np.asarray(r, dtype=float)
+            scale = np.abs(r).max() or 1.0
+            l2 = np.sqrt(np.mean((f - r) ** 2)) / (np.sqrt(np.mean(r ** 2)) or 1.0)
+            linf = np.abs(f - r).max() / scale
+            q, qref = wavenumber(f, ref["L0"]), wavenumber(r, ref["L0"])
+            dq = abs(q - qref) / qref if qref > 0 else 0.0
+            print(f"{name}\t{field}\t{l2:.3e}\t{linf:.3e}\t{dq:.3e}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
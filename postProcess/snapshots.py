@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Read the binary snapshot streams written by src-local/snapshot.h.
+
+A stream is a sequence of frames, each made of a header (1024 bytes,
+512 for versions 1 and 2) followed by nf x n x n doubles on uniform
+grids, or by the values,
+levels and indices of the nc leaf cells of adaptive grids (see
+snapshot.h for the layout). The field data are memory-mapped, so that
+only the frames (and fields) actually used are read from disk.
+
+Usage as a module:
+
+    from snapshots import read_snapshots
+    for frame in read_snapshots("simulationCases/keller-segel/snapshots.bin"):
+        rho = frame["fields"]["rho"]      # (n, n) array, y varying slowest
+        print(frame["t"], rho.max())
+
+Frames of adaptive runs hold 1D arrays of leaf values, with their
+levels and indices in frame["cells"]; uniform(frame) samples them on a
+uniform grid.
+
+Usage from the command line (lists the frames of a stream):
+
+    python3 postProcess/snapshots.py simulationCases/keller-segel/snapshots.bin
+"""
+
+import sys
+
+import numpy as np
+
+
+def _header(parameters):
+    return np.dtype([
+        ("magic", "S8"),
+        ("version", "<i4"),
+        ("level", "<i4"),
+        ("n", "<i4"),
+        ("nfields", "<i4"),
+        ("i", "<i4"),
+        ("cells", "<i4"),
+        ("t", "<f8"),
+        ("L0", "<f8"),
+        ("X0", "<f8"),
+        ("Y0", "<f8"),
+        ("fields", "S192"),
+        ("parameters", f"S{parameters}"),
+    ])
+
+
+# Header of each format version: 1 (uniform) and 2 (leaf cells) have 256
+# bytes of parameters, 3 (either, leaf cells when "cells" > 0) has 768.
+HEADERS = {1: _header(256), 2: _header(256), 3: _header(768)}
+assert HEADERS[1].itemsize == 512 and HEADERS[3].itemsize == 1024
+
+
+def _text(value):
+    return value.split(b"\0", 1)[0].decode()
+
+
+def read_snapshots(path):
+    """Yield the frames of a stream as dictionaries.
+
+    Each frame has the keys "t", "i", "level", "n", "L0", "X0", "Y0",
+    "parameters" (a dictionary of floats) and "fields" (a dictionary of
+    read-only (n, n) memory-mapped arrays). The frames of adaptive grids
+    instead have (nc,) arrays of leaf values in "fields", and a "cells"
+    dictionary of (nc,) arrays "level", "i" and "j". A trailing
+    incomplete frame, e.g. one being written by a running simulation,
+    is ignored.
+    """
+    data = np.memmap(path, dtype=np.uint8, mode="r")
+    offset = 0
+    while offset + 12 <= data.size:
+        version = int(data[offset + 8:offset + 12].view("<i4")[0])
+        if bytes(data[offset:offset + 8]) != b"SNAPSHOT" or version not in HEADERS:
+            raise ValueError(f"{path}: invalid frame header at byte {offset}")
+        size = HEADERS[version].itemsize
+        if offset + size > data.size:
+            break
+        header = data[offset:offset + size].view(HEADERS[version])[0]
+        n, nf, nc = int(header["n"]), int(header["nfields"]), int(header["cells"])
+        start = offset + size
+        uniform_frame = version == 1 or (version == 3 and nc == 0)
+        if uniform_frame:
+            end = start + 8 * nf * n * n
+        else:
+            end = start + (8 * nf + 12) * nc
+        if end > data.size:
+            break
+        cells = None
+        if uniform_frame:
+            values = data[start:end].view("<f8").reshape(nf, n, n)
+        else:
+            middle = start + 8 * nf * nc
+            values = data[start:middle].view("<f8").reshape(nf, nc)
+            level, i, j = data[middle:end].view("<i4").reshape(3, nc)
+            cells = {"level": level, "i": i, "j": j}
+        names = _text(header["fields"]).split()
+        parameters = {}
+        for pair in _text(header["parameters"]).split():
+            name, _, value = pair.partition("=")
+            try:
+                parameters[name] = float(value)
+            except ValueError:
+                # e.g. a pair cut by the 256 bytes of versions 1 and 2
+                continue
+        frame = {
+            "t": float(header["t"]),
+            "i": int(header["i"]),
+            "level": int(header["level"]),
+            "n": n,
+            "L0": float(header["L0"]),
+            "X0": float(header["X0"]),
+            "Y0": float(header["Y0"]),
+            "parameters": parameters,
+            "fields": dict(zip(names, values)),
+        }
+        if cells is not None:
+            frame["cells"] = cells
+        yield frame
+        offset = end
+
+
+def uniform(frame, level=None):
+    """Return the fields of a frame as (n, n) arrays at a given level.
+
+    Uniform frames are returned as they are (level must then be theirs).
+    For the leaf cells of adaptive frames (default level: the depth of
+    the tree), coarser leaves fill all the samples they cover and finer
+    ones are averaged, as in the uniform sampling of snapshot.h.
+    """
+    if "cells" not in frame:
+        if level is not None and level != frame["level"]:
+            raise ValueError("uniform frames cannot be resampled")
+        return frame["fields"]
+    level = frame["level"] if level is None else level
+    n = 1 << level
+    cells = frame["cells"]
+    fields = {}
+    for name, values in frame["fields"].items():
+        out = np.zeros((n, n))
+        for lev in np.unique(cells["level"]):
+            mask = cells["level"] == lev
+            i, j, v = cells["i"][mask], cells["j"][mask], values[mask]
+            if lev <= level:
+                m = 1 << (level - lev)
+                r = np.arange(m)
+                rows = (j[:, None] * m + r)[:, :, None]
+                cols = (i[:, None] * m + r)[:, None, :]
+                out[rows, cols] = v[:, None, None]
+            else:
+                shift = lev - level
+                np.add.at(out, (j >> shift, i >> shift), v / 4.0 ** shift)
+        fields[name] = out
+    return fields
+
+
+def main(argv):
+    if len(argv) != 2:
+        print(f"Usage: {argv[0]} <snapshots.bin>", file=sys.stderr)
+        return 1
+    for frame in read_snapshots(argv[1]):
+        size = f"cells={frame['cells']['level'].size}" if "cells" in frame else f"n={frame['n']}"
+        ranges = " ".join(
+            f"{name}=[{field.min():g},{field.max():g}]"
+            for name, field in frame["fields"].items()
+        )
+        parameters = " ".join(f"{k}={v:g}" for k, v in frame["parameters"].items())
+        print(f"i={frame['i']} t={frame['t']:g} {size} {ranges} ({parameters})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,285 @@
+/**
+# Brusselator: Batched Instances
+
+This is the [Brusselator](brusselator.c) case (same model, parameters
+and split scheme) for $K$ = `BATCH` instances advanced side by side in
+a single process, e.g.
+
+~~~bash
+./runCases.sh -D BATCH=8 brusselator-batch mu=0.04 dmu=0.1
+~~~
+
+runs the eight values $\mu = 0.04, 0.14, \dots, 0.74$ at once. Sweeps
+over many small ($128^2$) grids otherwise pay the start-up of a
+process, the initialisation and the set-up of the solvers for every
+point, while a single $128^2$ grid cannot keep the cores of a node
+busy.
+
+Each field is stored as $K$ *lanes*, one per instance (see
+[batched.h](../src-local/batched.h)), and `BATCH` is fixed at compile
+time. The reaction kernels update all the lanes of a cell in an inner
+loop of fixed length $K$ over consecutive field indices, and the
+diffusion solves of the $K$ instances share the traversals of the
+multigrid hierarchy, with the same loop over the lanes in the
+smoother. All the instances use the same timestep and run to the same
+final time.
+
+Instance $l$ has the control parameter $\mu_l = \mu + l\,\delta\mu$
+(`mu`, `dmu`) and its random perturbation is drawn from stream $l$ of
+[rng.h](../src-local/rng.h): with `dmu=0`, a batch is an ensemble of
+$K$ realisations of the same point, and the first instance starts from
+the same perturbation as the unbatched run of this point.
+
+## Author
+
+Vatsal Sanjay  
+Email: vatsalsy@comphy-lab.org  
+CoMPhy Lab  
+Last updated: Oct 16, 2026
+*/
+
+#include "grid/multigrid.h"
+#include "run.h"
+#include "batched.h"
+#include "parameters.h"
+#include "checkpoint.h"
+#include "profiling.h"
+#include "diagnostics.h"
+#include "rng.h"
+
+/**
+## Variables
+
+The lanes of the concentrations and of the solver workspace are
+allocated at the start of each run (see [event init()](#event-init)). */
+
+scalar * C1 = NULL, * C2 = NULL;
+scalar * rhs1 = NULL, * lambda1 = NULL, * rhs2 = NULL, * lambda2 = NULL;
+scalar * resid = NULL;
+
+/**
+## Parameters
+
+The model parameters of [brusselator.c](brusselator.c), with the
+control parameter of instance $l$ given by `mu` and `dmu`, and the
+same run parameters (`N`, `nsteps`, `chkwall`, `chksteps`,
+`diagevery`, `seed`, `member`). */
+
+double k = 1., ka = 4.5, D = 8.;
+double mu = 0.04, dmu = 0.1;
+double kb[BATCH], one[BATCH], DC2[BATCH];
+
+double dt;
+mgstats mgd1, mgd2;
+int nsteps = 0;
+
+Parameter params[] = {
+  {"mu", &mu},
+  {"dmu", &dmu},
+  {"k", &k},
+  {"ka", &ka},
+  {"D", &D},
+  {"dtmax", &DT},
+  {"N", NULL, &N},
+  {"nsteps", NULL, &nsteps},
+  {"chkwall", &checkpoint_wall},
+  {"chksteps", NULL, &checkpoint_steps},
+  {"diagevery", NULL, &diagnostics_every},
+  {"seed", NULL, &rng_seed},
+  {"member", NULL, &rng_member},
+  {NULL}
+};
+
+int main (int argc, char * argv[])
+{
+  N = 128;
+  TOLERANCE = 1e-4;
+  DT = 1.;
+  read_parameters (argc, argv, params);
+  init_grid (N);
+  size (64);
+  run();
+}
+
+/**
+## Initial Conditions
+
+### event init()
+
+Each instance starts from its (unstable) stationary solution, see
+[brusselator.c](brusselator.c#event-init), or resumes from the
+checkpoint of the batch. */
+
+event init (i = 0)
+{
+  timer tm = timer_start();
+  C1 = batched_new ("C1"), C2 = batched_new ("C2");
+  rhs1 = batched_new ("rhs1"), lambda1 = batched_new ("lambda1");
+  rhs2 = batched_new ("rhs2"), lambda2 = batched_new ("lambda2");
+  resid = batched_new ("resid");
+
+  sprintf (checkpoint_name, "checkpoint-batch-%d-mu-%g-dmu-%g", BATCH, mu, dmu);
+  scalar * list = list_concat (C1, C2);
+  bool restarted = restart (list, params, &dt);
+  free (list);
+
+  double kbcrit = sq(1. + ka*sqrt(1./D));
+  for (int l = 0; l < BATCH; l++) {
+    kb[l] = kbcrit*(1. + mu + l*dmu);
+    one[l] = 1., DC2[l] = D;
+  }
+
+  if (!restarted)
+    foreach()
+      for (int l = 0; l < BATCH; l++) {
+	scalar c1 = lane (C1, l), c2 = lane (C2, l);
+	c1[] = ka;
+	c2[] = kb[l]/ka + 0.01*rng_noise (point, l);
+      }
+  profile_event ("init", tm);
+}
+
+/**
+## Monitoring
+
+Every `diagevery` steps, the mass, minimum, maximum and $L^2$ norm of
+every lane are appended to `diagnostics.csv` (see
+[diagnostics.h](../src-local/diagnostics.h)), with columns
+`C1_<l>_mass`, ... for instance $l$. The progress of the batch is
+printed on standard error. The statistics of all the lanes are
+accumulated in a single sweep. */
+
+event monitor (i++)
+{
+  if (!diagnostics_due())
+    return 0;
+  timer tm = timer_start();
+  double m[2*BATCH], fmin[2*BATCH], fmax[2*BATCH], f2[2*BATCH];
+  for (int l = 0; l < 2*BATCH; l++)
+    m[l] = f2[l] = 0., fmin[l] = HUGE, fmax[l] = - HUGE;
+  foreach (serial)
+    for (int l = 0; l < 2*BATCH; l++) {
+      scalar s = l < BATCH ? lane (C1, l) : lane (C2, l - BATCH);
+      m[l] += dv()*s[], f2[l] += dv()*sq(s[]);
+      fmin[l] = min (fmin[l], s[]), fmax[l] = max (fmax[l], s[]);
+    }
+  mpi_all_reduce_array (m, MPI_DOUBLE, MPI_SUM, 2*BATCH);
+  mpi_all_reduce_array (f2, MPI_DOUBLE, MPI_SUM, 2*BATCH);
+  mpi_all_reduce_array (fmin, MPI_DOUBLE, MPI_MIN, 2*BATCH);
+  mpi_all_reduce_array (fmax, MPI_DOUBLE, MPI_MAX, 2*BATCH);
+
+  FieldStats stats[2*BATCH];
+  for (int l = 0; l < BATCH; l++) {
+    int j = BATCH + l;
+    stats[2*l] = (FieldStats){C1[l].name, m[l], fmin[l], fmax[l], f2[l]};
+    stats[2*l + 1] = (FieldStats){C2[l].name, m[j], fmin[j], fmax[j], f2[j]};
+  }
+  diagnostics_write (stats, 2*BATCH, params);
+  fprintf (stderr, "%d %g %g %d %d\n", i, t, dt, mgd1.i, mgd2.i);
+  profile_event ("monitor", tm);
+}
+
+/**
+## Outputs
+
+### event final()
+
+The final pattern of each instance is saved as `mu-<mu_l>.png`, as for
+the unbatched case. */
+
+event final (t = 3000)
+{
+  timer tm = timer_start();
+  int l = 0;
+  for (scalar c1 in C1) {
+    char name[80];
+    sprintf (name, "mu-%g.png", mu + l*dmu);
+    output_ppm (c1, file = name, n = 200, linear = true, spread = 2);
+    l++;
+  }
+  checkpoint_done();
+  profile_event ("final", tm);
+}
+
+event profiling (t = end)
+{
+  profile_summary (params);
+}
+
+/**
+The lanes are freed at the end of each run. */
+
+event cleanup (t = end)
+{
+  batched_free (&C1), batched_free (&C2);
+  batched_free (&rhs1), batched_free (&lambda1);
+  batched_free (&rhs2), batched_free (&lambda2);
+  batched_free (&resid);
+}
+
+/**
+## Checkpoints
+
+The checkpoint holds the lanes of both species. */
+
+event checkpoints (i++)
+{
+  timer tm = timer_start();
+  if (checkpoint_due()) {
+    scalar * list = list_concat (C1, C2);
+    checkpoint (list, params, dt);
+    free (list);
+  }
+  profile_event ("checkpoints", tm);
+}
+
+/**
+## Time Integration
+
+### event integration()
+
+The split scheme of [brusselator.c](brusselator.c#event-integration):
+the fused reaction kernel assembles the right-hand side and diagonal
+coefficient of $C_1$ for all the lanes of a cell, the $C_1$ problems
+of all the instances are solved with one batched multigrid solve, and
+the same is then done for $C_2$ from the updated $C_1$. */
+
+event integration (i++)
+{
+  timer tm = timer_start();
+  dt = dtnext (DT);
+
+  foreach()
+    for (int l = 0; l < BATCH; l++) {
+      scalar c1 = lane (C1, l), c2 = lane (C2, l);
+      scalar r1 = lane (rhs1, l), l1 = lane (lambda1, l);
+      double u = c1[];
+      r1[] = - u/dt - k*ka;
+      l1[] = k*(u*c2[] - kb[l] - 1.) - 1./dt;
+    }
+  mgd1 = batched_helmholtz (C1, rhs1, lambda1, one, res = resid);
+
+  foreach()
+    for (int l = 0; l < BATCH; l++) {
+      scalar c1 = lane (C1, l), c2 = lane (C2, l);
+      scalar r2 = lane (rhs2, l), l2 = lane (lambda2, l);
+      double u = c1[];
+      r2[] = - c2[]/dt - k*kb[l]*u;
+      l2[] = - k*sq(u) - 1./dt;
+    }
+  mgd2 = batched_helmholtz (C2, rhs2, lambda2, DC2, res = resid);
+  profile_step (tm, dt, mgd1, mgd2);
+}
+
+/**
+## Fixed-Step Runs
+
+With `nsteps=<n>` on the command line, the run stops after $n$
+timesteps, e.g. to compare the throughput of a batch with that of $K$
+separate runs of [brusselator.c](brusselator.c). */
+
+event stop (i++)
+{
+  if (nsteps > 0 && i + 1 >= nsteps)
+    return 1;
+}
@@ -22,7 +22,20 @@ We use the same parameters as [Pena and Perez-Garcia, 2001](/src/references.bib#
 ## Implementation
 
 We use a Cartesian (multi)grid, the generic time loop, and the
-time-implicit diffusion solver from Basilisk.
+time-implicit diffusion discretisation of Basilisk's
+[diffusion.h](/src/diffusion.h), solved with the multigrid
+Poisson--Helmholtz solver. Compiling with
+`-DCOUPLED=1` replaces the species-by-species solves with a linearly
+implicit step of the coupled system (see [coupled.h](../src-local/coupled.h)).
+Compiling with `-DADAPT=1` replaces the uniform multigrid with an
+adaptive quadtree (see [Mesh Adaptation](#mesh-adaptation)). Compiling
+with `-DSPECTRAL=1` makes the domain periodic and replaces the multigrid
+solves with exact solves in Fourier space (see
+[spectral.h](../src-local/spectral.h)). Adding `-DETDRK4=1` to
+`-DSPECTRAL=1` replaces the first-order step with the fourth-order
+exponential integrator ETDRK4, which allows much larger timesteps.
+Compiling with `-DDTCONTROL=1` adapts the timestep to a tolerance on
+the local error (see [dtcontrol.h](../src-local/dtcontrol.h)).
 
 ## Author
 
@@ -32,9 +45,39 @@ CoMPhy Lab
 Last updated: Jan 30, 2026
 */
 
-#include "grid/multigrid.h"
+#if ADAPT
+# include "grid/quadtree.h"
+#else
+# include "grid/multigrid.h"
+#endif
 #include "run.h"
-#include "diffusion.h"
+#include "poisson.h"
+#include "parameters.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+#include "profiling.h"
+#include "movie.h"
+#include "steady.h"
+#include "diagnostics.h"
+#include "rng.h"
+#if COUPLED
+# include "coupled.h"
+#endif
+#if SPECTRAL
+# if COUPLED
+#  error "SPECTRAL and COUPLED are exclusive"
+# endif
+# include "spectral.h"
+#elif ETDRK4
+# error "ETDRK4 requires SPECTRAL"
+#endif
+#if DTCONTROL
+# include "dtcontrol.h"
+#endif
+#if !COUPLED && !SPECTRAL
+# include "helmholtz.h"
+# include "warmstart.h"
+#endif
 
 /**
 ## Variables
@@ -51,12 +94,53 @@ Model parameters from [Pena and Perez-Garcia, 2001](/src/references.bib#pena2001
 - `k`: Reaction rate constant (default: 1.0)
 - `ka`: Parameter controlling $C_1$ production (default: 4.5)
 - `D`: Diffusion coefficient ratio for $C_2$ (default: 8.0)
-- `mu`: Control parameter for bifurcation analysis
+- `mu`: Control parameter for bifurcation analysis (default: 0.1 for
+  a single run)
 - `kb`: Derived parameter based on `mu`
+
+A parameter can also be compiled in as a constant with `runCases.sh
+-B name=value` (see [parameters.h](../src-local/parameters.h)), so
+that the kinetics and the solver coefficients fold to immediate values.
+When `mu`, `ka` and `D` are all baked, so is `kb`.
 */
 
-double k = 1., ka = 4.5, D = 8.;
-double mu, kb;
+#ifdef BAKED_k
+static const double k = BAKED_k;
+#else
+double k = 1.;
+#endif
+#ifdef BAKED_ka
+static const double ka = BAKED_ka;
+#else
+double ka = 4.5;
+#endif
+#ifdef BAKED_D
+static const double D = BAKED_D;
+#else
+double D = 8.;
+#endif
+#ifdef BAKED_mu
+static const double mu = BAKED_mu;
+#else
+double mu = 0.1;
+#endif
+#if defined(BAKED_mu) && defined(BAKED_ka) && defined(BAKED_D)
+# define kb (sq(1. + ka*sqrt(1./D))*(1. + mu))
+#else
+double kb;
+#endif
+
+/**
+With `-DADAPT=1`, the refinement is controlled by:
+
+- `C1err`, `C2err`: Tolerated wavelet errors on $C_1$ and $C_2$ (default: 1e-3)
+- `maxlevel`: Maximum level of refinement (default: 9, i.e. 512 × 512)
+- `minlevel`: Minimum level of refinement (default: 5, i.e. 32 × 32) */
+
+#if ADAPT
+double C1err = 1e-3, C2err = 1e-3;
+int maxlevel = 9, minlevel = 5;
+#endif
 
 /**
 The generic time loop requires a timestep `dt`. We store the statistics
@@ -65,6 +149,125 @@ of the diffusion solvers in `mgd1` and `mgd2` for monitoring convergence. */
 double dt;
 mgstats mgd1, mgd2;
 
+/**
+## Solver Workspace
+
+The right-hand sides and diagonal coefficients of the implicit solves
+and the residuals of the multigrid solver live for the whole run. They
+are reused at every timestep (and, for the split scheme, the residual
+is shared by both species) instead of being allocated and freed at
+every step by the integration event and within `diffusion()`. */
+
+#if COUPLED
+scalar b1[], b2[], l11[], l12[], l21[], l22[], res1[], res2[];
+#elif SPECTRAL
+scalar rhs1[], rhs2[];
+#else
+scalar rhs1[], lambda1[], rhs2[], lambda2[], resid[];
+#endif
+
+/**
+The split scheme starts each solve from a guess extrapolated from the
+two previous steps (see [warmstart.h](../src-local/warmstart.h)),
+which needs the previous state of both species. */
+
+#if !COUPLED && !SPECTRAL
+scalar C1old[], C2old[];
+WarmStart warm1 = {"C1"}, warm2 = {"C2"};
+#endif
+
+/**
+With `-DDTCONTROL=1`, the timestep controller also needs a copy of the
+state at the beginning of the step and the result of the full step. */
+
+#if DTCONTROL
+scalar C1save[], C2save[], C1full[], C2full[];
+#endif
+
+/**
+The steady-state monitor keeps a copy of $C_1$ between its checks (see
+[steady.h](../src-local/steady.h)). */
+
+scalar C1prev[];
+
+/**
+The parameters which can be set on the command line (see
+[parameters.h](../src-local/parameters.h)) are also recorded in the
+snapshots and checkpoints. Besides the model parameters:
+
+- `N`: Grid resolution $N\times N$, a power of two (default: 128)
+- `nsteps`: If positive, stop each run after `nsteps` timesteps, e.g.
+  for benchmarks (default: 0)
+- `chkwall`, `chksteps`: Interval between checkpoints in seconds of
+  wall time (default: 900) and in iterations (default: 0, i.e. disabled)
+- `steadytol`: Stop a run once the relative rates of change of $C_1$
+  and of its dominant wavenumber stay below `steadytol` (default: 0,
+  i.e. always run to $t = 3000$; e.g. 1e-5 to stop on a saturated
+  pattern)
+- `diagevery`: Interval in iterations between the rows of
+  `diagnostics.csv` (default: 10, 0 to disable)
+- `seed`, `member`: Seed of the random perturbation of the initial
+  conditions and index of the realisation within an ensemble (default:
+  0, see [rng.h](../src-local/rng.h))
+- `warmstart`: Without `-DCOUPLED=1` or `-DSPECTRAL=1`, start the
+  multigrid solves from the extrapolation of the two previous steps
+  (default: 1, 0 to start from the current state)
+- `tolfactor`: With the warm start, converge each solve to this
+  fraction of the time error estimated at the previous step, instead
+  of the fixed tolerance 1e-4 (default: 0, i.e. fixed; see
+  [tolsched.h](../src-local/tolsched.h))
+- `dttol`: With `-DDTCONTROL=1`, tolerance on the relative local error
+  of a timestep (default: 1e-3)
+*/
+
+int nsteps = 0;
+
+Parameter params[] = {
+#ifdef BAKED_mu
+  {"mu", .baked = &mu},
+#else
+  {"mu", &mu},
+#endif
+#ifdef BAKED_k
+  {"k", .baked = &k},
+#else
+  {"k", &k},
+#endif
+#ifdef BAKED_ka
+  {"ka", .baked = &ka},
+#else
+  {"ka", &ka},
+#endif
+#ifdef BAKED_D
+  {"D", .baked = &D},
+#else
+  {"D", &D},
+#endif
+  {"dtmax", &DT},
+  {"N", NULL, &N},
+  {"nsteps", NULL, &nsteps},
+  {"chkwall", &checkpoint_wall},
+  {"chksteps", NULL, &checkpoint_steps},
+  {"steadytol", &steady_tol},
+  {"diagevery", NULL, &diagnostics_every},
+  {"seed", NULL, &rng_seed},
+  {"member", NULL, &rng_member},
+#if !COUPLED && !SPECTRAL
+  {"warmstart", NULL, &warmstart},
+  {"tolfactor", &tolsched_factor},
+#endif
+#if DTCONTROL
+  {"dttol", &dtcontrol_tol},
+#endif
+#if ADAPT
+  {"C1err", &C1err},
+  {"C2err", &C2err},
+  {"maxlevel", NULL, &maxlevel},
+  {"minlevel", NULL, &minlevel},
+#endif
+  {NULL}
+};
+
 /**
 ### main()
 
@@ -72,30 +275,61 @@ Main simulation driver. Initializes the grid and solver parameters,
 then runs simulations for multiple control parameter values.
 
 We configure:
-- Grid resolution: 128 × 128
+- Grid resolution: `N` × `N` = 128 × 128 (initial resolution with `-DADAPT=1`)
 - Domain size: 64 × 64
 - Diffusion solver tolerance: 1e-4
+- Maximum timestep `DT` (`dtmax` on the command line): 1 (20 with
+  `-DDTCONTROL=1`, where the timestep is set by the error tolerance)
+- Boundaries: symmetry (periodic with `-DSPECTRAL=1`)
 
 Here $\mu$ is the control parameter. For $\mu > 0$ the system is
 supercritical (Hopf bifurcation). We test several values of $\mu$ to
-observe different pattern formation regimes. */
+observe different pattern formation regimes.
+
+Any of the parameters can be given on the command line as
+`name=value` pairs (see [parameters.h](../src-local/parameters.h)), in
+which case a single simulation is run for this parameter point, with
+$\mu = 0.1$ (stripes) unless `mu` is given. This is how
+[runSweep.sh](runSweep.sh) launches the points of a sweep. When `mu`
+is compiled in, the single run is for this value. */
 
-int main()
+int main (int argc, char * argv[])
 {
-  init_grid (128);
-  size (64);
+  N = 128;
   TOLERANCE = 1e-4;
+  DT = 1.;
+#if DTCONTROL
+  DT = 20.;
+# if ETDRK4
+  dtcontrol_order = 4;
+# endif
+#endif
+  int set = read_parameters (argc, argv, params);
+#if SPECTRAL
+  periodic (right);
+  periodic (top);
+#endif
+  init_grid (N);
+  size (64);
+  if (set) {
+    run();
+    return 0;
+  }
 
   /**
-  Run three cases covering different bifurcation regimes:
+  Without arguments, run three cases covering different bifurcation regimes:
   - $\mu = 0.04$: Weak instability
   - $\mu = 0.1$: Stripe patterns
   - $\mu = 0.98$: Hexagonal patterns
   */
 
+#ifdef BAKED_mu
+  run();
+#else
   mu = 0.04; run();
   mu = 0.1;  run();
   mu = 0.98; run();
+#endif
 }
 
 /**
@@ -109,22 +343,97 @@ The marginal stability is obtained for `kb = kbcrit`. We calculate:
 - $\nu = \sqrt{1/D}$: characteristic wavenumber
 - $k_b^{crit} = (1 + ka \cdot \nu)^2$: critical bifurcation parameter
 - $kb = k_b^{crit}(1 + \mu)$: actual parameter based on control value $\mu$
+
+If a checkpoint of this run exists (see
+[checkpoint.h](../src-local/checkpoint.h)), the run resumes from it
+instead of starting from the stationary solution.
 */
 
 event init (i = 0)
 {
+  timer tm = timer_start();
+  sprintf (checkpoint_name, "checkpoint-mu-%g", mu);
+  bool restarted = restart ({C1, C2}, params, &dt);
+
+#ifndef kb
   double nu = sqrt(1./D);
   double kbcrit = sq(1. + ka*nu);
   kb = kbcrit*(1. + mu);
+#endif
 
   /**
   The (unstable) stationary solution is $C_1 = ka$ and $C_2 = kb/ka$. We
-  perturb it with random noise in $[-0.01, 0.01]$ to trigger pattern formation. */
+  perturb it with random noise in $[-0.01, 0.01]$ to trigger pattern formation.
+  The noise of a cell depends only on its position, `seed` and `member`
+  (see [rng.h](../src-local/rng.h)). */
+
+  if (!restarted)
+    foreach() {
+      C1[] = ka;
+      C2[] = kb/ka + 0.01*rng_noise (point, 0);
+    }
+  profile_event ("init", tm);
+}
 
-  foreach() {
-    C1[] = ka ; 
-    C2[] = kb/ka + 0.01*noise();
+/**
+## Monitoring
+
+### event monitor()
+
+Every 10 steps, a single sweep over the grid computes the reductions
+needed by the monitors of the run:
+
+* the diagnostics written to `diagnostics.csv` (see
+  [diagnostics.h](../src-local/diagnostics.h)): the mass, minimum,
+  maximum and $L^2$ norm of $C_1$ and $C_2$,
+* with `steadytol=<tol>`, the steady-state monitor of
+  [steady.h](../src-local/steady.h), which checks whether $C_1$ and the
+  wavelength of its pattern have stopped evolving. Once they have for
+  10 consecutive checks, the settling time is recorded in `steady.csv`,
+  the final outputs are saved and the run stops, instead of
+  integrating up to $t = 3000$.
+
+This event comes before the integration, so that the outputs are those
+of the time checked. */
+
+static void final_outputs (void);
+
+event monitor (i++)
+{
+  bool diag = diagnostics_due(), check = steady_due();
+  if (!diag && !check)
+    return 0;
+  timer tm = timer_start();
+  double m1 = 0., min1 = HUGE, max1 = - HUGE, s1 = 0.;
+  double m2 = 0., min2 = HUGE, max2 = - HUGE, s2 = 0.;
+  double grad = 0., diff = 0.;
+  foreach (reduction(+:m1) reduction(min:min1) reduction(max:max1)
+	   reduction(+:s1) reduction(+:m2) reduction(min:min2)
+	   reduction(max:max2) reduction(+:s2) reduction(+:grad)
+	   reduction(max:diff)) {
+    double c1 = C1[], c2 = C2[];
+    m1 += dv()*c1, s1 += dv()*sq(c1);
+    min1 = min (min1, c1), max1 = max (max1, c1);
+    m2 += dv()*c2, s2 += dv()*sq(c2);
+    min2 = min (min2, c2), max2 = max (max2, c2);
+    if (check) {
+      foreach_dimension()
+	grad += dv()*sq((C1[1] - C1[-1])/(2.*Delta));
+      diff = max (diff, fabs (c1 - C1prev[]));
+      C1prev[] = c1;
+    }
   }
+
+  if (diag)
+    diagnostics_write ((FieldStats[]){{"C1", m1, min1, max1, s1},
+				       {"C2", m2, min2, max2, s2}}, 2, params);
+  bool stop = check &&
+    steady_check (diff, steady_amplitude (sq(L0), m1, min1, max1),
+		  steady_wavenumber (sq(L0), m1, s1, grad), params);
+  if (stop)
+    final_outputs();
+  profile_event ("monitor", tm);
+  return stop;
 }
 
 /**
@@ -134,15 +443,36 @@ event init (i = 0)
 
 Generate animation frames showing the evolution of $C_1$ concentration.
 
-We output PPM images every 10 iterations for video generation. The
+We capture a frame every 10 iterations for video generation. The
 `spread` parameter sets the color scale to $\pm$ twice the standard
-deviation, highlighting pattern structures. Progress information (iteration,
+deviation, highlighting pattern structures. The frames are encoded in
+the background (see [movie.h](../src-local/movie.h)), so that the time
+loop only pays for copying the field. Progress information (iteration,
 time, timestep, and solver iterations) is printed to stderr for monitoring. */
 
 event movie (i = 1; i += 10)
 {
-  output_ppm (C1, linear = true, spread = 2, file = "f.mp4", n = 200);
+  timer tm = timer_start();
+  movie_frame (C1, "f.mp4", n = 200, spread = 2);
   fprintf (stderr, "%d %g %g %d %d\n", i, t, dt, mgd1.i, mgd2.i);
+  profile_event ("movie", tm);
+}
+
+/**
+### event snapshots()
+
+Every 10 iterations (starting from the initial condition), append the
+raw cell values of $C_1$ and $C_2$ to the binary stream `snapshots.bin` (see
+[snapshot.h](../src-local/snapshot.h)), which can be read with
+[snapshots.py](../postProcess/snapshots.py). With `-DADAPT=1`, the
+frames hold the leaf cells of the adaptive grid, whose size follows
+the number of cells rather than `maxlevel`. */
+
+event snapshots (i += 10)
+{
+  timer tm = timer_start();
+  snapshot ({C1, C2}, "snapshots.bin", params = params);
+  profile_event ("snapshots", tm);
 }
 
 /**
@@ -151,13 +481,53 @@ event movie (i = 1; i += 10)
 Save final steady-state pattern as a PNG image.
 
 The image filename encodes the $\mu$ value for easy identification of
-different bifurcation regimes. */
+different bifurcation regimes. The run is complete, so its checkpoint
+is removed. The same outputs are saved when the run stops early on a
+steady state (see [event monitor()](#event-monitor)). */
 
-event final (t = 3000)
+static void final_outputs (void)
 {
   char name[80];
   sprintf (name, "mu-%g.png", mu);
   output_ppm (C1, file = name, n = 200, linear = true, spread = 2);
+  checkpoint_done();
+}
+
+event final (t = 3000)
+{
+  timer tm = timer_start();
+  final_outputs();
+  profile_event ("final", tm);
+}
+
+/**
+### event profiling()
+
+The events are timed with [profiling.h](../src-local/profiling.h),
+which also logs the multigrid statistics of every timestep to
+`profile.csv`. At the end of each run, append the summary of the
+timings and solver statistics to `profile.json`. */
+
+event profiling (t = end)
+{
+  profile_summary (params);
+}
+
+/**
+## Checkpoints
+
+### event checkpoints()
+
+Save the fields and the state of the run when a checkpoint is due (see
+[checkpoint.h](../src-local/checkpoint.h)). This event comes before
+the integration, so that the fields are saved at the current time. */
+
+event checkpoints (i++)
+{
+  timer tm = timer_start();
+  if (checkpoint_due())
+    checkpoint ({C1, C2}, params, dt);
+  profile_event ("checkpoints", tm);
 }
 
 /**
@@ -171,45 +541,213 @@ We separate each reaction-diffusion equation into:
 $$
 \partial_t C = D \nabla^2 C + r + \beta C
 $$
-where `r` and `beta` are the source term and linear coefficient respectively.
+where `r` and `beta` are the source term and linear coefficient
+respectively. As in [diffusion.h](/src/diffusion.h), the implicit step
+is the Poisson--Helmholtz problem
+$$
+\nabla\cdot(D\nabla C^{n+1}) + (\beta - 1/\Delta t) C^{n+1} =
+- C^n/\Delta t - r
+$$
+whose right-hand side and diagonal coefficient we assemble directly in
+the workspace fields.
 
 #### Algorithm
 
-1. Set adaptive timestep (max 1.0 for stability of reactive terms)
-2. Solve $C_1$ with implicit diffusion:
+1. Set adaptive timestep (max `DT` = 1.0 for stability of reactive terms)
+2. Assemble the source term and coefficient of $C_1$ in a single sweep
+   over the grid, reading $C_1^n$ and $C_2^n$ once, and solve $C_1$
+   with implicit diffusion:
    $$
-   \partial_t C_1 = \nabla^2 C_1 + k k_a + k (C_1 C_2 - k_b - 1) C_1
+   \partial_t C_1 = \nabla^2 C_1 + k k_a + k (C_1^n C_2^n - k_b - 1) C_1
    $$
-3. Solve $C_2$ with implicit diffusion (diffusion coefficient $D$):
+3. Assemble both terms of $C_2$ in a single sweep from the updated
+   $C_1^{n+1}$, and solve $C_2$ with implicit diffusion (diffusion
+   coefficient $D$):
    $$
-   \partial_t C_2 = D \nabla^2 C_2  + k k_b C_1 - k C_1^2 C_2
+   \partial_t C_2 = D \nabla^2 C_2  + k k_b C_1^{n+1} - k (C_1^{n+1})^2 C_2
    $$
+
+#### Coupled Algorithm (`-DCOUPLED=1`)
+
+The splitting above lags the coupling between species, which limits the
+timestep for stiff kinetics (large $k_b$). Instead, we linearise the
+reaction terms $\mathbf{F}(\mathbf{C})$ around the current state with
+their Jacobian $\mathbf{J}$ (linearly implicit Euler)
+$$
+\frac{\mathbf{C}^{n+1} - \mathbf{C}^n}{\Delta t} =
+\mathbf{D}\nabla^2\mathbf{C}^{n+1} + \mathbf{F}(\mathbf{C}^n) +
+\mathbf{J}(\mathbf{C}^{n+1} - \mathbf{C}^n)
+$$
+and solve for $C_1$ and $C_2$ together with the block multigrid solver.
+The explicit remainder $\mathbf{F} - \mathbf{J}\mathbf{C}^n$ is
+$(k k_a - 2kC_1^2C_2,\; 2kC_1^2C_2)$. Larger values of `dtmax` can
+then be used.
+
+#### Spectral Algorithm (`-DSPECTRAL=1`)
+
+On the periodic domain, each species is advanced with
+[spectral_solve()](../src-local/spectral.h), which solves the implicit
+step exactly in Fourier space, without iterations (the multigrid
+statistics are then zero). The decay terms are implicit, with constant
+coefficients: $k(k_b + 1)$ for $C_1$ and, for $C_2$, the stationary
+value $\sigma_2 = k k_a^2$ of $kC_1^2$, whose departure from
+$kC_1^2C_2$ is treated explicitly
+$$
+\partial_t C_2 = D \nabla^2 C_2 - \sigma_2 C_2 +
+k k_b C_1^n - k (C_1^n)^2 C_2^n + \sigma_2 C_2^n
+$$
+so that the step remains stable where the pattern is close to the
+stationary solution. The explicit terms are computed by: */
+
+#if SPECTRAL
+static void kinetics (scalar * u, scalar * n)
+{
+  scalar c1 = u[0], c2 = u[1], n1 = n[0], n2 = n[1];
+  double sigma2 = k*sq(ka);
+  foreach() {
+    double r = k*sq(c1[])*c2[];
+    n1[] = k*ka + r;
+    n2[] = k*kb*c1[] - r + sigma2*c2[];
+  }
+}
+#endif
+
+/**
+#### Exponential Integrator (`-DSPECTRAL=1 -DETDRK4=1`)
+
+With the same splitting into a linear part, diagonal in Fourier space,
+and the explicit terms above, the fourth-order exponential
+time-differencing Runge--Kutta scheme of
+[spectral_etdrk4()](../src-local/spectral.h) integrates diffusion and
+decay exactly and the kinetics at fourth order. The timestep is then
+only limited by the accuracy of the kinetics rather than by the
+stability of the lagged reaction terms, e.g. `dtmax=5` reaches
+$t = 3000$ in a fifth of the steps of the default. Each step costs
+four evaluations of the kinetics and twenty FFTs.
+
+#### Adaptive Timestep (`-DDTCONTROL=1`)
+
+Each of the schemes above is written as a function advancing both
+species by a given timestep from the current state. The timestep is
+then either the maximum `DT`, or chosen by the step-doubling
+controller of [dtcontrol.h](../src-local/dtcontrol.h) from the
+tolerance `dttol`: large during the slow coarsening of the patterns,
+small during the fast transients. The multigrid statistics reported
+are then those of the last half step.
 */
 
-event integration (i++)
+#if !COUPLED && !SPECTRAL
+static mgstats solve1 (scalar a)
 {
-  dt = dtnext (1.);
+  return helmholtz (a, rhs1, lambda = lambda1, res = {resid});
+}
+
+static mgstats solve2 (scalar a)
+{
+  const face vector c[] = {D, D};
+  return helmholtz (a, rhs2, c, lambda2, res = {resid});
+}
+#endif
+
+static void advance (double dt)
+{
+#if COUPLED
+  foreach() {
+    double C12 = sq(C1[])*C2[];
+    b1[] = - C1[]/dt - k*(ka - 2.*C12);
+    b2[] = - C2[]/dt - 2.*k*C12;
+    l11[] = k*(2.*C1[]*C2[] - kb - 1.) - 1./dt;
+    l12[] = k*sq(C1[]);
+    l21[] = k*(kb - 2.*C1[]*C2[]);
+    l22[] = - k*sq(C1[]) - 1./dt;
+  }
+  const face vector c[] = {D, D};
+  mgd1 = mgd2 = coupled (C1, C2, b1, b2, alpha22 = c,
+			 lambda11 = l11, lambda12 = l12,
+			 lambda21 = l21, lambda22 = l22,
+			 res = {res1, res2});
+#elif ETDRK4
+  spectral_etdrk4 ({C1, C2}, {rhs1, rhs2}, dt, (double[]){1., D},
+		   (double[]){k*(kb + 1.), k*sq(ka)}, kinetics);
+#elif SPECTRAL
+  kinetics ({C1, C2}, {rhs1, rhs2});
+  spectral_solve (C1, rhs1, dt, 1., k*(kb + 1.));
+  spectral_solve (C2, rhs2, dt, D, k*sq(ka));
+#else
 
   /**
-  Solve for $C_1$ with source term $r = k \cdot ka$ and coefficient
-  $\beta = k(C_1 C_2 - k_b - 1)$. */
+  The fused reaction kernels: the source term and coefficient of each
+  species are computed in a single sweep, the constant source $k k_a$
+  being folded into the right-hand side. The loop bodies are
+  branch-free so that they can be vectorised by the compiler. */
 
-  scalar r[], beta[];
-  
   foreach() {
-    r[] = k*ka;
-    beta[] = k*(C1[]*C2[] - kb - 1.);
+    double c1 = C1[];
+    rhs1[] = - c1/dt - k*ka;
+    lambda1[] = k*(c1*C2[] - kb - 1.) - 1./dt;
   }
-  mgd1 = diffusion (C1, dt, r = r, beta = beta);
 
   /**
-  Solve for $C_2$ with anisotropic diffusion coefficient $D$ and
-  source/sink terms depending on current $C_1$ field. */
+  Solve for $C_1$, then for $C_2$ with anisotropic diffusion
+  coefficient $D$ and the updated $C_1$, each from its extrapolated
+  guess, with the solver of [helmholtz.h](../src-local/helmholtz.h),
+  which adapts the solves to the precision of the fields. */
+
+  mgd1 = warmstart_solve (C1, C1old, dt, solve1, &warm1);
 
   foreach() {
-    r[] = k*kb*C1[];
-    beta[] = - k*sq(C1[]);
+    double c1 = C1[];
+    rhs2[] = - C2[]/dt - k*kb*c1;
+    lambda2[] = - k*sq(c1) - 1./dt;
   }
-  const face vector c[] = {D, D};
-  mgd2 = diffusion (C2, dt, c, r, beta);
+  mgd2 = warmstart_solve (C2, C2old, dt, solve2, &warm2);
+#endif
+}
+
+event integration (i++)
+{
+  timer tm = timer_start();
+#if DTCONTROL
+  dt = dtcontrol_step ({C1, C2}, {C1save, C2save}, {C1full, C2full},
+		       DT, advance);
+#else
+  dt = dtnext (DT);
+  advance (dt);
+#endif
+  profile_step (tm, dt, mgd1, mgd2);
+}
+
+/**
+## Mesh Adaptation
+
+### event adapt()
+
+With `-DADAPT=1`, the grid is adapted after each timestep with the
+wavelet-based criterion of [Basilisk](/src/grid/tree-common.h#adapt_wavelet),
+on both concentrations. Turing patterns fill the whole domain, so the
+gain is smaller than for the localised aggregates of the Keller--Segel
+case: the grid mostly coarsens during the transient and in the
+smooth parts of the patterns. */
+
+#if ADAPT
+event adapt (i++)
+{
+  timer tm = timer_start();
+  adapt_wavelet ({C1, C2}, (double[]){C1err, C2err}, maxlevel, minlevel);
+  profile_event ("adapt", tm);
+}
+#endif
+
+/**
+## Fixed-Step Runs
+
+### event stop()
+
+With `nsteps=<n>` on the command line, each run stops after $n$
+timesteps, whatever the time reached. */
+
+event stop (i++)
+{
+  if (nsteps > 0 && i + 1 >= nsteps)
+    return 1;
 }
@@ -0,0 +1,103 @@
+#!/bin/bash
+# common.sh - Build and launch helpers shared by the run scripts
+#
+# Description:
+#   Sourced by the run scripts (not executed directly). The
+#   parallel mode is chosen on the command line of these scripts, so the
+#   case sources never need to be edited:
+#     serial  plain qcc build, one thread
+#     openmp  qcc -fopenmp, launched with OMP_NUM_THREADS=<np>
+#     mpi     CC99='mpicc -std=c99' qcc -D_MPI=1, launched with mpirun -np <np>
+#
+#   Cases built with -DSPECTRAL=1 are linked with FFTW (and its threaded
+#   library with OpenMP); this mode does not support MPI.
+#
+#   With MPI, the number of ranks must be compatible with the domain
+#   decomposition of the multigrid (e.g. 4, 16 or 64 in 2D).
+#
+#   The precision of the fields is also chosen at build time:
+#     double  default
+#     single  -DSINGLE_PRECISION=1, fields stored as float, solver tolerance
+#             raised to the float rounding floor
+#     mixed   single, with the implicit solves refined in double precision
+#             (-DMIXED_PRECISION=1, see src-local/helmholtz.h); split scheme
+#             on uniform grids only
+#
+# Functions:
+#   check_mode                              Validate $MODE and $NP
+#   precision_flags <double|single|mixed>   Print the qcc options of a precision
+#   build_case <source> <executable> [qcc options]...
+#   launch_case <executable> [name=value]...
+#   json_value <file> <object> <key>        Value of a key of a profile.json summary
+#   case_point <case>                       Print the control parameter of a
+#                                           patterned run of a case (e.g. mu=0.1)
+#
+# Environment:
+#   MODE    serial, openmp or mpi
+#   NP      number of OpenMP threads or MPI ranks
+#   MPIRUN  MPI launcher (default: mpirun)
+
+check_mode() {
+  case "$MODE" in
+    serial|openmp|mpi) ;;
+    *) echo "Unknown mode '$MODE' (expected serial, openmp or mpi)" >&2; return 1 ;;
+  esac
+  if ! [[ "$NP" =~ ^[1-9][0-9]*$ ]]; then
+    echo "Invalid number of threads/ranks '$NP'" >&2
+    return 1
+  fi
+}
+
+precision_flags() {
+  case "$1" in
+    double) ;;
+    single) echo "-DSINGLE_PRECISION=1" ;;
+    mixed) echo "-DSINGLE_PRECISION=1 -DMIXED_PRECISION=1" ;;
+    *) echo "Unknown precision '$1' (expected double, single or mixed)" >&2; return 1 ;;
+  esac
+}
+
+build_case() {
+  local source="$1" executable="$2"
+  shift 2
+  local libs=(-lm -lpthread)
+  if [[ " $* " == *" -DSPECTRAL=1 "* ]]; then
+    libs=(-lfftw3 "${libs[@]}")
+    [[ "$MODE" == openmp ]] && libs=(-lfftw3_omp "${libs[@]}")
+  fi
+  case "$MODE" in
+    serial) qcc "$@" "$source" -o "$executable" "${libs[@]}" ;;
+    openmp) qcc -fopenmp "$@" "$source" -o "$executable" "${libs[@]}" ;;
+    mpi) CC99='mpicc -std=c99' qcc -D_MPI=1 "$@" "$source" -o "$executable" "${libs[@]}" ;;
+  esac
+}
+
+launch_case() {
+  local executable="$1"
+  shift
+  case "$MODE" in
+    serial) "$executable" "$@" ;;
+    openmp) OMP_NUM_THREADS="$NP" "$executable" "$@" ;;
+    mpi) ${MPIRUN:-mpirun} -np "$NP" "$executable" "$@" ;;
+  esac
+}
+
+# Prints the value of the first occurrence of a numeric key of the
+# (single-line) JSON summary, optionally within an object, e.g.
+#   json_value summary.json mg1 cycles_per_step
+json_value() {
+  awk -v object="$2" -v key="\"$3\": " '{
+    s = $0
+    if (object != "") { i = index(s, "\"" object "\": {"); if (!i) exit; s = substr(s, i) }
+    i = index(s, key); if (!i) exit
+    s = substr(s, i + length(key)); sub(/[,}].*/, "", s); print s
+  }' "$1"
+}
+
+case_point() {
+  case "$1" in
+    brusselator|brusselator-batch) echo "mu=0.1" ;;
+    keller-segel) echo "chi=5" ;;
+    *) echo "Unknown case '$1'" >&2; return 1 ;;
+  esac
+}
@@ -24,7 +24,20 @@ where:
 ## Implementation
 
 We use a Cartesian (multi)grid, the generic time loop, and the
-time-implicit diffusion solver from Basilisk.
+time-implicit diffusion discretisation of Basilisk's
+[diffusion.h](/src/diffusion.h), solved with the multigrid
+Poisson--Helmholtz solver. The chemotactic flux is
+treated explicitly with the upwind face fluxes of
+[chemotaxis.h](../src-local/chemotaxis.h) (implicit-explicit splitting).
+Compiling with `-DCOUPLED=1` instead solves for $\rho$ and $c$ together,
+with an implicit chemotactic flux (see [coupled.h](../src-local/coupled.h)).
+Compiling with `-DADAPT=1` replaces the uniform multigrid with a
+quadtree, refined on the aggregates (see [Mesh Adaptation](#mesh-adaptation)).
+Compiling with `-DSPECTRAL=1` makes the domain periodic and replaces
+the multigrid solves with exact solves in Fourier space, with a
+pseudo-spectral chemotactic flux (see [spectral.h](../src-local/spectral.h)).
+Compiling with `-DDTCONTROL=1` adapts the timestep to a tolerance on
+the local error (see [dtcontrol.h](../src-local/dtcontrol.h)).
 
 ## Author
 
@@ -32,77 +45,304 @@ Vatsal Sanjay
 Email: vatsalsy@comphy-lab.org  
 CoMPhy Lab  
 Last updated: Jan 30, 2026
-
-## Note
-
-This file is currently configured as a Brusselator example and requires
-adaptation to implement the actual Keller-Segel chemotaxis equations.
 */
 
-#include "grid/multigrid.h"
+#if ADAPT
+# include "grid/quadtree.h"
+#else
+# include "grid/multigrid.h"
+#endif
 #include "run.h"
-#include "diffusion.h"
+#include "poisson.h"
+#include "chemotaxis.h"
+#include "parameters.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+#include "profiling.h"
+#include "movie.h"
+#include "steady.h"
+#include "blowup.h"
+#include "diagnostics.h"
+#include "rng.h"
+#if COUPLED
+# include "coupled.h"
+#endif
+#if SPECTRAL
+# if COUPLED
+#  error "SPECTRAL and COUPLED are exclusive"
+# endif
+# include "spectral.h"
+#endif
+#if DTCONTROL
+# include "dtcontrol.h"
+#endif
+#if !COUPLED && !SPECTRAL
+# include "helmholtz.h"
+# include "warmstart.h"
+#endif
 
 /**
 ## Variables
 
-We define scalar fields for the concentrations `C1` and `C2`.
-In the Keller-Segel model these would represent cell density $\rho$ and
-chemoattractant concentration $c$ respectively. */
+We define scalar fields for the cell density `rho` and the
+chemoattractant concentration `c`. */
 
-scalar C1[], C2[];
+scalar rho[], c[];
 
 /**
 ## Parameters
 
-Placeholder parameters from [Pena and Perez-Garcia, 2001](/src/references.bib#pena2001).
-These need to be adapted for the Keller-Segel model:
+- `chi`: Chemotactic sensitivity (default: 5.0)
+- `D`: Diffusion coefficient of the chemoattractant (default: 1.0)
+- `alpha`: Production rate of the chemoattractant (default: 1.0)
+- `beta`: Degradation rate of the chemoattractant (default: 1.0)
+- `rho0`: Mean cell density (default: 1.0)
+
+The homogeneous state $\rho = \rho_0$, $c = \alpha\rho_0/\beta$ is
+linearly unstable to modes of wavenumber $q$ such that
+$\chi\alpha\rho_0 > D q^2 + \beta$, i.e. for $\chi > 1$ with the
+default parameters.
+
+A parameter can also be compiled in as a constant with `runCases.sh
+-B name=value` (see [parameters.h](../src-local/parameters.h)), so
+that the chemotactic flux, the kinetics and the solver coefficients
+fold to immediate values. */
+
+#ifdef BAKED_chi
+static const double chi = BAKED_chi;
+#else
+double chi = 5.;
+#endif
+#ifdef BAKED_D
+static const double D = BAKED_D;
+#else
+double D = 1.;
+#endif
+#ifdef BAKED_alpha
+static const double alpha = BAKED_alpha;
+#else
+double alpha = 1.;
+#endif
+#ifdef BAKED_beta
+static const double beta = BAKED_beta;
+#else
+double beta = 1.;
+#endif
+#ifdef BAKED_rho0
+static const double rho0 = BAKED_rho0;
+#else
+double rho0 = 1.;
+#endif
 
-- `k`: Reaction/chemotaxis rate (placeholder: 1.0)
-- `ka`: Production parameter (placeholder: 4.5)
-- `D`: Diffusion coefficient (placeholder: 8.0)
-- `mu`: Control parameter
-- `kb`: Derived parameter
-*/
+/**
+With `-DADAPT=1`, the refinement is controlled by:
 
-double k = 1., ka = 4.5, D = 8.;
-double mu, kb;
+- `rhoerr`, `cerr`: Tolerated wavelet errors on $\rho$ and $c$ (default: 1e-2, 1e-3)
+- `maxlevel`: Maximum level of refinement (default: 11, i.e. 2048 × 2048)
+- `minlevel`: Minimum level of refinement (default: 5, i.e. 32 × 32) */
+
+#if ADAPT
+double rhoerr = 1e-2, cerr = 1e-3;
+int maxlevel = 11, minlevel = 5;
+#endif
 
 /**
 The generic time loop requires a timestep `dt`. We store the statistics
-of the diffusion solvers in `mgd1` and `mgd2` for monitoring convergence. */
+of the diffusion solvers for $\rho$ and $c$ in `mgd1` and `mgd2` for
+monitoring convergence. */
 
 double dt;
 mgstats mgd1, mgd2;
 
+/**
+## Solver Workspace
+
+The right-hand sides of the implicit solves, the residuals of the
+multigrid solver and the face velocity/flux (resp. cross-diffusion
+coefficient) live for the whole run. They are reused at every timestep
+(and, for the split scheme, the residual is shared by both species)
+instead of being allocated and freed at every step by the integration
+event and within `diffusion()`. The diagonal coefficients are constant
+fields, which are never allocated. */
+
+#if COUPLED
+scalar b1[], b2[], res1[], res2[];
+face vector a12[];
+#elif SPECTRAL
+scalar rhs1[], rhs2[];
+vector gc[];
+#else
+scalar rhs1[], rhs2[], resid[];
+face vector u[];
+#endif
+
+/**
+The split scheme starts each solve from a guess extrapolated from the
+two previous steps (see [warmstart.h](../src-local/warmstart.h)),
+which needs the previous state of both species. */
+
+#if !COUPLED && !SPECTRAL
+scalar rhoold[], cold[];
+WarmStart warm1 = {"rho"}, warm2 = {"c"};
+#endif
+
+/**
+With `-DDTCONTROL=1`, the timestep controller also needs a copy of the
+state at the beginning of the step and the result of the full step. */
+
+#if DTCONTROL
+scalar rhosave[], csave[], rhofull[], cfull[];
+#endif
+
+/**
+The steady-state monitor keeps a copy of $\rho$ between its checks (see
+[steady.h](../src-local/steady.h)). */
+
+scalar rhoprev[];
+
+/**
+The parameters which can be set on the command line (see
+[parameters.h](../src-local/parameters.h)) are also recorded in the
+snapshots and checkpoints. Besides the model parameters:
+
+- `N`: Grid resolution $N\times N$, a power of two (default: 128)
+- `nsteps`: If positive, stop each run after `nsteps` timesteps, e.g.
+  for benchmarks (default: 0)
+- `chkwall`, `chksteps`: Interval between checkpoints in seconds of
+  wall time (default: 900) and in iterations (default: 0, i.e. disabled)
+- `steadytol`: Stop a run once the relative rates of change of $\rho$
+  and of its dominant wavenumber stay below `steadytol` (default: 0,
+  i.e. always run to $t = 3000$: the slow coarsening of the aggregates
+  is not a steady state)
+- `blowup`: What to do when an aggregate collapses below the
+  resolution of the grid: 0 to stop, 1 to also shrink the timestep as
+  the density grows, 2 to also refine (with `-DADAPT=1`) before
+  stopping (default: 0, see [event monitor()](#event-monitor))
+- `blowupcell`: Fraction of the critical mass $8\pi/\chi$ held by a
+  single cell beyond which an aggregate is unresolved (default: 0.1)
+- `diagevery`: Interval in iterations between the rows of
+  `diagnostics.csv` (default: 10, 0 to disable)
+- `seed`, `member`: Seed of the random perturbation of the initial
+  conditions and index of the realisation within an ensemble (default:
+  0, see [rng.h](../src-local/rng.h))
+- `warmstart`: Without `-DCOUPLED=1` or `-DSPECTRAL=1`, start the
+  multigrid solves from the extrapolation of the two previous steps
+  (default: 1, 0 to start from the current state)
+- `tolfactor`: With the warm start, converge each solve to this
+  fraction of the time error estimated at the previous step, instead
+  of the fixed tolerance 1e-4 (default: 0, i.e. fixed; see
+  [tolsched.h](../src-local/tolsched.h))
+- `dttol`: With `-DDTCONTROL=1`, tolerance on the relative local error
+  of a timestep (default: 1e-3)
+*/
+
+int nsteps = 0;
+
+Parameter params[] = {
+#ifdef BAKED_chi
+  {"chi", .baked = &chi},
+#else
+  {"chi", &chi},
+#endif
+#ifdef BAKED_D
+  {"D", .baked = &D},
+#else
+  {"D", &D},
+#endif
+#ifdef BAKED_alpha
+  {"alpha", .baked = &alpha},
+#else
+  {"alpha", &alpha},
+#endif
+#ifdef BAKED_beta
+  {"beta", .baked = &beta},
+#else
+  {"beta", &beta},
+#endif
+#ifdef BAKED_rho0
+  {"rho0", .baked = &rho0},
+#else
+  {"rho0", &rho0},
+#endif
+  {"dtmax", &DT},
+  {"N", NULL, &N},
+  {"nsteps", NULL, &nsteps},
+  {"chkwall", &checkpoint_wall},
+  {"chksteps", NULL, &checkpoint_steps},
+  {"steadytol", &steady_tol},
+  {"diagevery", NULL, &diagnostics_every},
+  {"seed", NULL, &rng_seed},
+  {"member", NULL, &rng_member},
+#if !COUPLED && !SPECTRAL
+  {"warmstart", NULL, &warmstart},
+  {"tolfactor", &tolsched_factor},
+#endif
+  {"blowup", NULL, &blowup_action},
+  {"blowupcell", &blowup_cell},
+#if DTCONTROL
+  {"dttol", &dtcontrol_tol},
+#endif
+#if ADAPT
+  {"rhoerr", &rhoerr},
+  {"cerr", &cerr},
+  {"maxlevel", NULL, &maxlevel},
+  {"minlevel", NULL, &minlevel},
+#endif
+  {NULL}
+};
+
 /**
 ### main()
 
-Main simulation driver (currently configured as Brusselator example).
+Main simulation driver.
 
 We configure:
-- Grid resolution: 128 × 128
+- Grid resolution: `N` × `N` = 128 × 128 (initial resolution with `-DADAPT=1`)
 - Domain size: 64 × 64
 - Diffusion solver tolerance: 1e-4
+- Maximum timestep `DT` (`dtmax` on the command line): 1 (20 with
+  `-DDTCONTROL=1`, where the timestep is set by the error tolerance)
+- Boundaries: symmetry (periodic with `-DSPECTRAL=1`)
 
-TODO: Adapt parameter sweep for Keller-Segel chemotaxis regimes. */
+Model parameters can be given on the command line as `name=value`
+pairs (see [parameters.h](../src-local/parameters.h)), in which case a
+single simulation is run for this parameter point. */
 
-int main()
+int main (int argc, char * argv[])
 {
-  init_grid (128);
-  size (64);
+  N = 128;
   TOLERANCE = 1e-4;
+  DT = 1.;
+#if DTCONTROL
+  DT = 20.;
+#endif
+  int set = read_parameters (argc, argv, params);
+#if SPECTRAL
+  periodic (right);
+  periodic (top);
+#endif
+  init_grid (N);
+  size (64);
+  if (set) {
+    run();
+    return 0;
+  }
 
   /**
-  Run three cases (currently Brusselator parameters):
-  - $\mu = 0.04$
-  - $\mu = 0.1$
-  - $\mu = 0.98$
+  Without arguments, run three chemotactic sensitivities, from weak
+  aggregation close to the instability threshold to strong aggregation:
+  - $\chi = 2$
+  - $\chi = 5$
+  - $\chi = 10$
   */
 
-  mu = 0.04; run();
-  mu = 0.1;  run();
-  mu = 0.98; run();
+#ifdef BAKED_chi
+  run();
+#else
+  chi = 2.;  run();
+  chi = 5.;  run();
+  chi = 10.; run();
+#endif
 }
 
 /**
@@ -110,30 +350,127 @@ int main()
 
 ### event init()
 
-Initialize concentration fields (currently using Brusselator setup).
-
-For Brusselator physics:
-- Calculate $\nu = \sqrt{1/D}$: characteristic wavenumber
-- Compute $k_b^{crit} = (1 + ka \cdot \nu)^2$: critical bifurcation parameter
-- Set $kb = k_b^{crit}(1 + \mu)$ based on control parameter $\mu$
+The homogeneous steady state $\rho = \rho_0$, $c = \alpha\rho_0/\beta$
+is perturbed by a random noise of relative amplitude $0.01$ to trigger
+aggregation. The noise of a cell depends only on its position, `seed`
+and `member` (see [rng.h](../src-local/rng.h)).
 
-TODO: Replace with Keller-Segel initial conditions (e.g., localized cell density,
-uniform chemoattractant). */
+If a checkpoint of this run exists (see
+[checkpoint.h](../src-local/checkpoint.h)), the run resumes from it
+instead. */
 
 event init (i = 0)
 {
-  double nu = sqrt(1./D);
-  double kbcrit = sq(1. + ka*nu);
-  kb = kbcrit*(1. + mu);
+  timer tm = timer_start();
+#if ADAPT
+  rho.refine = rho.prolongation = refine_linear;
+  rho.gradient = minmod2;
+#endif
+  sprintf (checkpoint_name, "checkpoint-chi-%g", chi);
+  if (!restart ({rho, c}, params, &dt))
+    foreach() {
+      rho[] = rho0*(1. + 0.01*rng_noise (point, 0));
+      c[] = alpha*rho0/beta;
+    }
+  profile_event ("init", tm);
+}
 
-  /**
-  Initialize near stationary solution $C_1 = ka$, $C_2 = kb/ka$ with
-  random perturbation in $[-0.01, 0.01]$. */
+/**
+## Monitoring
+
+### event monitor()
+
+Every step, before any output, a single sweep over the grid computes
+the reductions needed by the monitors of the run:
+
+* the diagnostics written every 10 steps to `diagnostics.csv` (see
+  [diagnostics.h](../src-local/diagnostics.h)): the mass, minimum,
+  maximum and $L^2$ norm of $\rho$ and $c$, and the free energy
+  $$
+  F = \int \rho\log\rho - \chi\rho c + \frac{\chi}{2\alpha}
+  \left(D|\nabla c|^2 + \beta c^2\right)
+  $$
+  which decreases in time. The mass of $\rho$ is conserved by the
+  finite-volume flux up to the tolerance of the solver.
+* the blow-up monitor of [blowup.h](../src-local/blowup.h). Above the
+  critical mass $8\pi/\chi$, aggregates collapse in finite time. When
+  an aggregate becomes unresolved, the run stops with an estimate of
+  the blow-up time (in the log and in `blowup.csv`) and its final
+  outputs, rather than producing invalid frames. With `blowup=2` and
+  `-DADAPT=1`, `maxlevel` is first raised, up to three times. When the
+  state itself is invalid (not finite, or not conserving mass beyond
+  the residual of the $\rho$ solves), the run stops without saving it
+  and keeps its last checkpoint, from which it can be resumed with a
+  smaller `dtmax` (see [checkpoint.h](../src-local/checkpoint.h)).
+* with `steadytol=<tol>`, the steady-state monitor of
+  [steady.h](../src-local/steady.h): every 10 steps, it checks whether
+  $\rho$ and the wavelength of the aggregates have stopped evolving.
+  Once they have for 10 consecutive checks, the settling time is
+  recorded in `steady.csv`, the final outputs are saved and the run
+  stops.
+
+The free energy and the steady-state quantities are only computed
+when they are due. */
+
+static void final_outputs (void);
+
+event monitor (i++)
+{
+  timer tm = timer_start();
+  bool diag = diagnostics_due(), check = steady_due();
+  double rmass = 0., rmin = HUGE, rmax = - HUGE, r2 = 0.;
+  double cmass = 0., cmin = HUGE, cmax = - HUGE, c2 = 0.;
+  double grad = 0., cell = 0., energy = 0., gradr = 0., diff = 0.;
+  foreach (reduction(+:rmass) reduction(min:rmin) reduction(max:rmax)
+	   reduction(+:r2) reduction(+:cmass) reduction(min:cmin)
+	   reduction(max:cmax) reduction(+:c2) reduction(max:grad)
+	   reduction(max:cell) reduction(+:energy) reduction(+:gradr)
+	   reduction(max:diff)) {
+    double r = rho[], cc = c[], g2 = 0.;
+    foreach_dimension()
+      g2 += sq((c[1] - c[-1])/(2.*Delta));
+    rmass += dv()*r, r2 += dv()*sq(r);
+    rmin = min (rmin, r), rmax = max (rmax, r);
+    cmass += dv()*cc, c2 += dv()*sq(cc);
+    cmin = min (cmin, cc), cmax = max (cmax, cc);
+    grad = max (grad, g2);
+    cell = max (cell, r*sq(Delta));
+    if (diag)
+      energy += dv()*((r > 0. ? r*log (r) : 0.) - chi*r*cc +
+		      chi/(2.*alpha)*(D*g2 + beta*sq(cc)));
+    if (check) {
+      foreach_dimension()
+	gradr += dv()*sq((rho[1] - rho[-1])/(2.*Delta));
+      diff = max (diff, fabs (r - rhoprev[]));
+      rhoprev[] = r;
+    }
+  }
 
-  foreach() {
-    C1[] = ka ; 
-    C2[] = kb/ka + 0.01*noise();
+  if (diag)
+    diagnostics_write ((FieldStats[]){{"rho", rmass, rmin, rmax, r2},
+				       {"c", cmass, cmin, cmax, c2}}, 2,
+		       params, energy);
+
+  bool stop = false;
+  int action = blowup_check (rmax, rmass, sqrt (grad), cell, 8.*pi/chi,
+			     params, dt*sq(L0)*mgd1.resa);
+  if (action == BLOWUP_STOP) {
+    if (blowup_valid())
+      final_outputs();
+    stop = true;
+  }
+#if ADAPT
+  else if (action == BLOWUP_REFINE)
+    maxlevel++;
+#endif
+  else if (check &&
+	   steady_check (diff, steady_amplitude (sq(L0), rmass, rmin, rmax),
+			 steady_wavenumber (sq(L0), rmass, r2, gradr), params)) {
+    final_outputs();
+    stop = true;
   }
+  profile_event ("monitor", tm);
+  return stop;
 }
 
 /**
@@ -141,33 +478,93 @@ event init (i = 0)
 
 ### event movie()
 
-Generate animation frames showing the evolution of $C_1$ concentration.
+Generate animation frames showing the evolution of the cell density.
 
-We output PPM images every 10 iterations for video generation. The
-`spread` parameter sets the color scale to $\pm$ twice the standard
-deviation. Progress information (iteration, time, timestep, and solver
-iterations) is printed to stderr for monitoring.
-
-TODO: Adapt visualization for Keller-Segel (cell density and chemotactic field). */
+We capture a frame every 10 iterations for video generation. The
+colour scale spans the instantaneous range of $\rho$. The frames are
+encoded in the background (see [movie.h](../src-local/movie.h)), so
+that the time loop only pays for copying the field. Progress
+information (iteration, time, timestep, and solver iterations) is
+printed to stderr for monitoring. */
 
 event movie (i = 1; i += 10)
 {
-  output_ppm (C1, linear = true, spread = 2, file = "f.mp4", n = 200);
+  timer tm = timer_start();
+  movie_frame (rho, "f.mp4", n = 200);
   fprintf (stderr, "%d %g %g %d %d\n", i, t, dt, mgd1.i, mgd2.i);
+  profile_event ("movie", tm);
+}
+
+/**
+### event snapshots()
+
+Every 10 iterations (starting from the initial condition), append the
+raw cell values of $\rho$ and $c$ to the binary stream `snapshots.bin` (see
+[snapshot.h](../src-local/snapshot.h)), which can be read with
+[snapshots.py](../postProcess/snapshots.py). With `-DADAPT=1`, the
+frames hold the leaf cells of the adaptive grid, whose size follows
+the number of cells rather than `maxlevel`. */
+
+event snapshots (i += 10)
+{
+  timer tm = timer_start();
+  snapshot ({rho, c}, "snapshots.bin", params = params);
+  profile_event ("snapshots", tm);
 }
 
 /**
 ### event final()
 
-Save final steady-state or aggregation pattern as a PNG image.
+Save the final aggregation pattern as a PNG image.
 
-The filename encodes the $\mu$ parameter value for identification. */
+The filename encodes the $\chi$ parameter value for identification.
+The run is complete, so its checkpoint is removed. The same outputs
+are saved when the run stops early on a steady state (see [event
+monitor()](#event-monitor)). */
 
-event final (t = 3000)
+static void final_outputs (void)
 {
   char name[80];
-  sprintf (name, "mu-%g.png", mu);
-  output_ppm (C1, file = name, n = 200, linear = true, spread = 2);
+  sprintf (name, "chi-%g.png", chi);
+  output_ppm (rho, file = name, n = 200, linear = true);
+  checkpoint_done();
+}
+
+event final (t = 3000)
+{
+  timer tm = timer_start();
+  final_outputs();
+  profile_event ("final", tm);
+}
+
+/**
+### event profiling()
+
+The events are timed with [profiling.h](../src-local/profiling.h),
+which also logs the multigrid statistics of every timestep to
+`profile.csv`. At the end of each run, append the summary of the
+timings and solver statistics to `profile.json`. */
+
+event profiling (t = end)
+{
+  profile_summary (params);
+}
+
+/**
+## Checkpoints
+
+### event checkpoints()
+
+Save the fields and the state of the run when a checkpoint is due (see
+[checkpoint.h](../src-local/checkpoint.h)). This event comes before
+the integration, so that the fields are saved at the current time. */
+
+event checkpoints (i++)
+{
+  timer tm = timer_start();
+  if (checkpoint_due())
+    checkpoint ({rho, c}, params, dt);
+  profile_event ("checkpoints", tm);
 }
 
 /**
@@ -175,75 +572,245 @@ event final (t = 3000)
 
 ### event integration()
 
-Advance the system by one timestep (currently Brusselator implementation).
+Advance the system by one timestep with an implicit-explicit splitting.
 
-For chemotaxis, this would use operator splitting or coupled implicit solvers
-to handle the chemotactic flux term $\chi \nabla \cdot (\rho \nabla c)$.
+#### Algorithm
 
-#### Current Algorithm (Brusselator)
-
-1. Set adaptive timestep (max 1.0 for stability)
-2. Solve $C_1$ with implicit diffusion:
+1. Compute the chemotactic velocity $\chi\nabla c^n$ on faces and set
+   the timestep from its CFL condition (capped by `DT`).
+2. Solve for $\rho$ with implicit diffusion and the explicit upwind
+   chemotactic flux as source term:
    $$
-   \partial_t C_1 = \nabla^2 C_1 + k k_a + k (C_1 C_2 - k_b - 1) C_1
+   \frac{\rho^{n+1} - \rho^n}{\Delta t} = \nabla^2 \rho^{n+1} -
+   \nabla\cdot(\rho^n\chi\nabla c^n)
    $$
-3. Solve $C_2$ with implicit diffusion (coefficient $D$):
+3. Solve for $c$ with implicit diffusion and degradation, using the
+   updated density as source:
    $$
-   \partial_t C_2 = D \nabla^2 C_2  + k k_b C_1 - k C_1^2 C_2
+   \frac{c^{n+1} - c^n}{\Delta t} = D \nabla^2 c^{n+1} + \alpha\rho^{n+1}
+   - \beta c^{n+1}
    $$
 
-TODO: Implement Keller-Segel chemotactic coupling. */
+#### Coupled Algorithm (`-DCOUPLED=1`)
 
-event integration (i++)
+The explicit flux limits the timestep to its CFL condition, which
+becomes very restrictive as aggregates steepen. With the block
+multigrid solver of [coupled.h](../src-local/coupled.h), we can instead
+take the gradient of the chemoattractant at the new time level
+$$
+\frac{\rho^{n+1} - \rho^n}{\Delta t} = \nabla^2 \rho^{n+1} -
+\nabla\cdot(\chi\rho^n_\text{up}\nabla c^{n+1})
+$$
+$$
+\frac{c^{n+1} - c^n}{\Delta t} = D \nabla^2 c^{n+1} + \alpha\rho^{n+1}
+- \beta c^{n+1}
+$$
+where the face density $\rho^n_\text{up}$ is upwinded according to
+the direction of $\nabla c^n$. The chemotactic flux then appears as
+the cross-diffusion coefficient $-\chi\rho^n_\text{up}$ of $c$ in the
+density equation, and the timestep is only limited by `DT`. Note that,
+unlike the explicit flux, this linearisation does not guarantee the
+positivity of $\rho$ for large timesteps.
+
+#### Spectral Algorithm (`-DSPECTRAL=1`)
+
+On the periodic domain, the splitting above is kept but both implicit
+steps are solved exactly in Fourier space with
+[spectral_solve()](../src-local/spectral.h), without iterations (the
+multigrid statistics are then zero). The gradient $\nabla c^n$ and the
+divergence of the chemotactic flux $\chi\rho^n\nabla c^n$ are
+computed pseudo-spectrally: the product is formed on the grid and the
+derivatives in Fourier space. The timestep is limited by the same CFL
+condition on the (cell-centered) chemotactic velocity. This flux is
+not upwinded, so that steep aggregates are resolved with Gibbs
+oscillations rather than numerical diffusion: the spectral mode is
+meant for the smooth regime of aggregation, not for blow-up.
+
+#### Adaptive Timestep (`-DDTCONTROL=1`)
+
+Each of the schemes above is written as two functions: `stability()`
+computes the chemotactic velocity of the current state and returns the
+largest stable timestep, and `advance()` then advances both fields by
+a given timestep. The timestep is either this stability limit, or
+chosen below it by the step-doubling controller of
+[dtcontrol.h](../src-local/dtcontrol.h) from the tolerance `dttol`:
+large during the slow growth of the instability, and as small as
+needed as the aggregates collapse. The multigrid statistics reported
+are then those of the last half step.
+*/
+
+static double stability (void)
 {
-  dt = dtnext (1.);
+#if COUPLED
+  return DT;
+#elif SPECTRAL
+  spectral_gradient (c, gc);
+  double dtmin = DT/CFL;
+  foreach (reduction(min:dtmin)) {
+    double out = 0.;
+    foreach_dimension()
+      out += chi*fabs (gc.x[]);
+    if (out*dtmin > Delta)
+      dtmin = Delta/out;
+  }
+  return CFL*dtmin;
+#else
+  return chemotaxis_velocity (c, chi, u, DT);
+#endif
+}
 
-  /**
-  Solve for $C_1$ with source term $r = k \cdot ka$ and coefficient
-  $\beta = k(C_1 C_2 - k_b - 1)$. */
+#if !COUPLED && !SPECTRAL
+static double dtsolve;
+
+static mgstats solve1 (scalar a)
+{
+  const scalar lrho[] = - 1./dtsolve;
+  return helmholtz (a, rhs1, lambda = lrho, res = {resid});
+}
+
+static mgstats solve2 (scalar a)
+{
+  const face vector Dc[] = {D, D};
+  const scalar lc[] = - beta - 1./dtsolve;
+  return helmholtz (a, rhs2, Dc, lc, res = {resid});
+}
+#endif
 
-  scalar r[], beta[];
-  
+static void advance (double dt)
+{
+#if COUPLED
+  const face vector Dc[] = {D, D};
+  foreach_face()
+    a12.x[] = - chi*(c[] > c[-1] ? rho[-1] : rho[]);
   foreach() {
-    r[] = k*ka;
-    beta[] = k*(C1[]*C2[] - kb - 1.);
+    b1[] = - rho[]/dt;
+    b2[] = - c[]/dt;
   }
-  mgd1 = diffusion (C1, dt, r = r, beta = beta);
+  const scalar l11[] = - 1./dt;
+  const scalar l21[] = alpha;
+  const scalar l22[] = - beta - 1./dt;
+  mgd1 = mgd2 = coupled (rho, c, b1, b2, alpha12 = a12, alpha22 = Dc,
+			 lambda11 = l11, lambda21 = l21, lambda22 = l22,
+			 res = {res1, res2});
+#elif SPECTRAL
+  foreach()
+    foreach_dimension()
+      gc.x[] *= - chi*rho[];
+  spectral_divergence (gc, rhs1);
+  spectral_solve (rho, rhs1, dt, 1., 0.);
+  foreach()
+    rhs2[] = alpha*rho[];
+  spectral_solve (c, rhs2, dt, D, beta);
+#else
 
   /**
-  Solve for $C_2$ with diffusion coefficient $D$ and source/sink terms. */
-
+  As in [diffusion.h](/src/diffusion.h), each implicit step is the
+  Poisson--Helmholtz problem $\nabla\cdot(D\nabla f^{n+1}) + (\beta -
+  1/\Delta t)f^{n+1} = - f^n/\Delta t - r$. The right-hand side of
+  $\rho$, including the divergence of the chemotactic flux, is
+  assembled in a single sweep, and that of $c$ from the updated
+  density. Both are solved with
+  [helmholtz.h](../src-local/helmholtz.h), which adapts the solves to
+  the precision of the fields. */
+
+  chemotaxis_flux (rho, u);
   foreach() {
-    r[] = k*kb*C1[];
-    beta[] = - k*sq(C1[]);
+    double div = 0.;
+    foreach_dimension()
+      div += (u.x[1] - u.x[])/Delta;
+    rhs1[] = - rho[]/dt + div;
   }
-  const face vector c[] = {D, D};
-  mgd2 = diffusion (C2, dt, c, r, beta);
+
+  dtsolve = dt;
+  mgd1 = warmstart_solve (rho, rhoold, dt, solve1, &warm1);
+
+  foreach()
+    rhs2[] = - c[]/dt - alpha*rho[];
+  mgd2 = warmstart_solve (c, cold, dt, solve2, &warm2);
+#endif
+}
+
+/**
+The steps of the controller start from states other than the current
+one, for which the chemotactic velocity must be computed again. */
+
+#if DTCONTROL
+static void substep (double dt)
+{
+  stability();
+  advance (dt);
+}
+#endif
+
+event integration (i++)
+{
+  timer tm = timer_start();
+#if DTCONTROL
+  dt = dtcontrol_step ({rho, c}, {rhosave, csave}, {rhofull, cfull},
+		       min (stability(), blowup_dtmax()), substep);
+#else
+  dt = dtnext (min (stability(), blowup_dtmax()));
+  advance (dt);
+#endif
+  profile_step (tm, dt, mgd1, mgd2);
+}
+
+/**
+## Mesh Adaptation
+
+### event adapt()
+
+With `-DADAPT=1`, the grid is adapted after each timestep with the
+wavelet-based criterion of [Basilisk](/src/grid/tree-common.h#adapt_wavelet):
+cells are refined where the interpolation error on $\rho$ or $c$
+exceeds `rhoerr` or `cerr` (i.e. across the steep fronts of the
+aggregates) and coarsened elsewhere, down to `minlevel`. This
+concentrates the resolution in the few aggregates, so that effective
+resolutions of $2^{11}\times 2^{11}$ and beyond can be used for the
+blow-up regime. Both solvers handle the resulting adaptive grids.
+
+Coarsening averages the children, which conserves the mass. The
+default bilinear interpolation used on refinement does not, so that
+$\rho$ is refined with the conservative linear reconstruction of
+[Basilisk](/src/grid/multigrid-common.h#refine_linear) instead, with
+slopes limited by `minmod2()`: the values of the children then stay
+within those of the neighbours of their parent, so that $\rho$ stays
+positive at the steep fronts of the aggregates (which the $\rho\log\rho$
+term of the free energy requires). Both are set in the
+[init](#event-init) event. */
+
+#if ADAPT
+event adapt (i++)
+{
+  timer tm = timer_start();
+  adapt_wavelet ({rho, c}, (double[]){rhoerr, cerr}, maxlevel, minlevel);
+  profile_event ("adapt", tm);
+}
+#endif
+
+/**
+## Fixed-Step Runs
+
+### event stop()
+
+With `nsteps=<n>` on the command line, each run stops after $n$
+timesteps, whatever the time reached. */
+
+event stop (i++)
+{
+  if (nsteps > 0 && i + 1 >= nsteps)
+    return 1;
 }
 
 /**
 ## Results
 
-Currently showing Brusselator [Turing
-patterns](http://en.wikipedia.org/wiki/The_Chemical_Basis_of_Morphogenesis).
-
-TODO: Replace with Keller-Segel chemotaxis results showing cell aggregation
-patterns, blow-up phenomena, or stable traveling waves depending on parameters.
-
-<center>
-<table>
-<tr>
-<td>![](brusselator/mu-0.04.png)</td>
-<td>![](brusselator/mu-0.1.png)</td>
- <td>![](brusselator/mu-0.98.png)</td>
-</tr>
-<tr>
-<td>$\mu=0.04$ (weak instability)</td> 
-<td>$\mu=0.1$ (stripe patterns)</td> 
-<td>$\mu=0.98$ (hexagonal patterns)</td>
-</tr>
-</table>
-</center>
-
-![Animation of pattern formation](brusselator/f.mp4)
+For $\chi\alpha\rho_0 > \beta$ the homogeneous state destabilises and
+the cells collect into aggregates, which then slowly coarsen. Beyond
+the critical mass $8\pi/\chi$ each aggregate collapses towards a point
+(finite-time blow-up of the continuous model), which the upwind flux
+regularises at the scale of the grid.
+
+Running the case writes `f.mp4` (evolution of $\rho$) and
+`chi-<value>.png` (final pattern) in `keller-segel/`.
 */
@@ -0,0 +1,186 @@
+#!/bin/bash
+# runBenchmarks.sh - Fixed-step benchmarks of the cases with scaling reports
+#
+# Description:
+#   Builds each case once with OpenMP, then runs it for a fixed number of
+#   timesteps (nsteps=) on a range of grid sizes (N=) and thread counts.
+#   The figures of every run are read from the profile.json summary that
+#   the cases write (see src-local/profiling.h) and collected in a table:
+#     point               model parameters of the runs (see below)
+#     cells_per_s         leaf cells x timesteps per second, whole run
+#     solver_cells_per_s  the same, for the integration event alone
+#     mg1_per_step        multigrid cycles per step, first species (or coupled)
+#     mg2_per_step        multigrid cycles per step, second species
+#     peak_rss_kb         peak resident set size
+#
+#   The table is compared with a baseline: a run is a regression when its
+#   solver throughput drops, or its multigrid cycles or memory grow, by
+#   more than the tolerance. Every case runs at a fixed parameter point
+#   where a pattern forms (brusselator mu=0.1, keller-segel chi=5), so that
+#   the multigrid cycle counts are those of a representative state rather
+#   than of a homogeneous one, and runs are only compared with baseline
+#   runs at the same point. Baselines are machine-specific, so none is
+#   committed: record one with -u on the machine used for the comparisons.
+#   Without a baseline (and without -u) the run fails, so that a missing
+#   baseline is not mistaken for a passing comparison. The ratio of the
+#   solver throughput of every run to that of the baseline is printed, so
+#   that a baseline recorded with other compile-time options gives the
+#   speed-up of the default build, e.g. over the coupled solver:
+#     ./runBenchmarks.sh -u -b benchmarks/coupled.tsv -D COUPLED=1
+#     ./runBenchmarks.sh -b benchmarks/coupled.tsv
+#
+# Usage:
+#   ./runBenchmarks.sh [-c "cases"] [-N "sizes"] [-t "threads"] [-s nsteps]
+#                      [-b baseline] [-r tolerance] [-u] [-D NAME=VALUE]...
+#
+# Options:
+#   -c cases        Cases to benchmark (default: "brusselator keller-segel")
+#   -N sizes        Grid sizes (default: "128 256 512 1024 2048")
+#   -t threads      Thread counts (default: 1, 2, 4, ... up to the number of cores)
+#   -s nsteps       Timesteps per run (default: 20)
+#   -b baseline     Baseline table (default: benchmarks/baseline.tsv)
+#   -r tolerance    Relative tolerance of the comparison (default: 0.1)
+#   -u              Store the results as the new baseline instead of comparing
+#   -D NAME=VALUE   Compile-time option of the cases (e.g. -D COUPLED=1)
+#
+# Outputs:
+#   simulationCases/benchmarks/<case>/N<size>-t<threads>/   outputs of each run
+#   simulationCases/benchmarks/results.tsv
+#
+# Exit status:
+#   1 if a run failed, the baseline is missing or a regression was found.
+
+set -euo pipefail
+
+usage() {
+  echo "Usage: $0 [-c \"cases\"] [-N \"sizes\"] [-t \"threads\"] [-s nsteps]" \
+    "[-b baseline] [-r tolerance] [-u] [-D NAME=VALUE]..." >&2
+  exit 1
+}
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+# shellcheck source=common.sh
+source "$SCRIPT_DIR/common.sh"
+
+CASES="brusselator keller-segel"
+SIZES="128 256 512 1024 2048"
+THREADS=""
+NSTEPS=20
+BENCH_DIR="$SCRIPT_DIR/benchmarks"
+BASELINE="$BENCH_DIR/baseline.tsv"
+TOLERANCE=0.1
+UPDATE=0
+DEFINES=()
+
+while getopts "c:N:t:s:b:r:uD:h" opt; do
+  case "$opt" in
+    c) CASES="$OPTARG" ;;
+    N) SIZES="$OPTARG" ;;
+    t) THREADS="$OPTARG" ;;
+    s) NSTEPS="$OPTARG" ;;
+    b) BASELINE="$OPTARG" ;;
+    r) TOLERANCE="$OPTARG" ;;
+    u) UPDATE=1 ;;
+    D) DEFINES+=("-D$OPTARG") ;;
+    *) usage ;;
+  esac
+done
+shift $((OPTIND - 1))
+[[ $# -eq 0 ]] || usage
+
+if [[ -z "$THREADS" ]]; then
+  cores=$(nproc 2>/dev/null || echo 1)
+  THREADS=1
+  for ((n = 2; n < cores; n *= 2)); do
+    THREADS="$THREADS $n"
+  done
+  (( cores > 1 )) && THREADS="$THREADS $cores"
+fi
+
+MODE="openmp"
+NP=1
+check_mode || usage
+REPO_ROOT=$(cd "$SCRIPT_DIR/.." && pwd)
+RESULTS="$BENCH_DIR/results.tsv"
+mkdir -p "$BENCH_DIR"
+
+failed=0
+printf "case\tpoint\tN\tthreads\tsteps\twall\tcells_per_s\tsolver_cells_per_s\tmg1_per_step\tmg2_per_step\tpeak_rss_kb\n" \
+  > "$RESULTS"
+for case in $CASES; do
+  point=$(case_point "$case") || usage
+  case_dir="$BENCH_DIR/$case"
+  mkdir -p "$case_dir"
+  (
+    cd "$REPO_ROOT"
+    build_case "$SCRIPT_DIR/$case.c" "$case_dir/$case" -I"$REPO_ROOT/src-local" -O2 -Wall -disable-dimensions ${DEFINES[@]+"${DEFINES[@]}"}
+  )
+  for size in $SIZES; do
+    for threads in $THREADS; do
+      run_dir="$case_dir/N$size-t$threads"
+      rm -rf "$run_dir"
+      mkdir -p "$run_dir"
+      echo "Running $case N=$size with $threads threads" >&2
+      status=0
+      (
+        cd "$run_dir"
+        NP="$threads" launch_case "$case_dir/$case" $point N="$size" nsteps="$NSTEPS" chkwall=0 > out 2> log
+      ) || status=$?
+      summary=$(tail -n 1 "$run_dir/profile.json" 2>/dev/null || true)
+      if [[ $status -ne 0 || -z "$summary" ]]; then
+        echo "  failed (status $status), see $run_dir/log" >&2
+        failed=$((failed + 1))
+        continue
+      fi
+      echo "$summary" > "$run_dir/summary.json"
+      printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n" "$case" "$point" "$size" "$threads" \
+        "$(json_value "$run_dir/summary.json" "" steps)" \
+        "$(json_value "$run_dir/summary.json" "" wall)" \
+        "$(json_value "$run_dir/summary.json" "" cells_per_s)" \
+        "$(json_value "$run_dir/summary.json" "" solver_cells_per_s)" \
+        "$(json_value "$run_dir/summary.json" mg1 cycles_per_step)" \
+        "$(json_value "$run_dir/summary.json" mg2 cycles_per_step)" \
+        "$(json_value "$run_dir/summary.json" "" peak_rss_kb)" >> "$RESULTS"
+    done
+  done
+done
+
+column -t -s $'\t' "$RESULTS" 2>/dev/null || cat "$RESULTS"
+
+if (( failed > 0 )); then
+  echo "$failed benchmark runs failed" >&2
+  exit 1
+fi
+
+if (( UPDATE )); then
+  mkdir -p "$(dirname "$BASELINE")"
+  cp "$RESULTS" "$BASELINE"
+  echo "Baseline stored in $BASELINE" >&2
+  exit 0
+fi
+
+if [[ ! -f "$BASELINE" ]]; then
+  echo "No baseline $BASELINE to compare with (store one with -u)" >&2
+  exit 1
+fi
+
+# Compare with the baseline, run by run (same case, point, size and threads).
+awk -F '\t' -v tol="$TOLERANCE" '
+  FNR == 1 { next }
+  NR == FNR { key = $1 FS $2 FS $3 FS $4; speed[key] = $8; mg1[key] = $9; mg2[key] = $10; rss[key] = $11; next }
+  {
+    key = $1 FS $2 FS $3 FS $4
+    run = sprintf ("%s %s N=%s t=%s", $1, $2, $3, $4)
+    if (!(key in speed)) { printf "%s: not in baseline\n", run; next }
+    if (speed[key] > 0)
+      printf "%s: solver throughput %.2fx baseline\n", run, $8/speed[key]
+    if ($8 < (1 - tol)*speed[key])
+      { printf "REGRESSION %s: %g cells/s (baseline %g)\n", run, $8, speed[key]; bad++ }
+    if ($9 > (1 + tol)*mg1[key] + 0.5 || $10 > (1 + tol)*mg2[key] + 0.5)
+      { printf "REGRESSION %s: %g + %g cycles/step (baseline %g + %g)\n", run, $9, $10, mg1[key], mg2[key]; bad++ }
+    if ($11 > (1 + tol)*rss[key])
+      { printf "REGRESSION %s: %d kB peak RSS (baseline %d kB)\n", run, $11, rss[key]; bad++ }
+  }
+  END { if (bad) { printf "%d regressions (tolerance %g)\n", bad, tol; exit 1 } }
+' "$BASELINE" "$RESULTS" >&2
+echo "No regression with respect to $BASELINE" >&2
@@ -2,26 +2,94 @@
 
 set -euo pipefail
 
-if [[ -z "${1:-}" ]]; then
-  echo "Usage: $0 <case-name>" >&2
+usage() {
+  echo "Usage: $0 [-m serial|openmp|mpi] [-n threads|ranks] [-p double|single|mixed] [-D NAME=VALUE]... [-B name=value]... [-f] <case-name> [name=value]..." >&2
+  echo "  -n  OpenMP threads (default: number of cores); MPI ranks, required with -m mpi" >&2
+  echo "  -p  precision of the fields (default: double, see common.sh)" >&2
+  echo "  -B  compile parameter <name> in as the constant <value> (see src-local/parameters.h)" >&2
+  echo "  -f  discard the checkpoints of the case and start from t = 0" >&2
   exit 1
+}
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+# shellcheck source=common.sh
+source "$SCRIPT_DIR/common.sh"
+
+MODE="serial"
+NP=""
+DEFINES=()
+BAKED=()
+FRESH=0
+PRECISION="double"
+while getopts "m:n:p:D:B:fh" opt; do
+  case "$opt" in
+    m) MODE="$OPTARG" ;;
+    n) NP="$OPTARG" ;;
+    p) PRECISION="$OPTARG" ;;
+    D) DEFINES+=("-D$OPTARG") ;;
+    B)
+      if [[ ! "$OPTARG" =~ ^[A-Za-z_][A-Za-z0-9_]*=[-+0-9.eE]+$ ]]; then
+        echo "Invalid baked parameter: $OPTARG" >&2
+        usage
+      fi
+      DEFINES+=("-DBAKED_$OPTARG")
+      BAKED+=("$OPTARG")
+      ;;
+    f) FRESH=1 ;;
+    *) usage ;;
+  esac
+done
+shift $((OPTIND - 1))
+if [[ -z "$NP" ]]; then
+  if [[ "$MODE" == mpi ]]; then
+    echo "-m mpi requires -n: the number of ranks must suit the domain decomposition (e.g. 4, 16 or 64)" >&2
+    usage
+  fi
+  NP=$(nproc 2>/dev/null || echo 1)
+fi
+check_mode || usage
+flags=$(precision_flags "$PRECISION") || usage
+read -r -a PRECISION_FLAGS <<< "$flags"
+
+if [[ -z "${1:-}" ]]; then
+  usage
 fi
 
 CASE_NAME="$1"
-SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+shift
 REPO_ROOT=$(cd "$SCRIPT_DIR/.." && pwd)
 CASE_DIR="$SCRIPT_DIR/$CASE_NAME"
 CASE_SOURCE="$SCRIPT_DIR/$CASE_NAME.c"
 
 mkdir -p "$CASE_DIR"
 
+# Runs resume automatically from their checkpoint (see src-local/checkpoint.h)
+shopt -s nullglob
+CHECKPOINTS=("$CASE_DIR"/checkpoint-*)
+shopt -u nullglob
+if [[ ${#CHECKPOINTS[@]} -gt 0 ]]; then
+  if [[ "$FRESH" -eq 1 ]]; then
+    echo "Discarding checkpoints in $CASE_DIR" >&2
+    rm -f "${CHECKPOINTS[@]}"
+  else
+    echo "Resuming from checkpoints in $CASE_DIR (use -f to start afresh):" >&2
+    for info in "$CASE_DIR"/checkpoint-*.info; do
+      [[ -f "$info" ]] || continue
+      echo "  $(basename "$info" .info): $(head -n 1 "$info" | cut -d' ' -f2,3)" >&2
+    done
+  fi
+fi
+
 cp "$CASE_SOURCE" "$CASE_DIR/"
+if [[ ${#BAKED[@]} -gt 0 ]]; then
+  echo "Compiling in ${BAKED[*]}" >&2
+fi
 
 (
   cd "$REPO_ROOT"
-  qcc -I"$REPO_ROOT/src-local" -O2 -Wall -disable-dimensions "$CASE_SOURCE" -o "$CASE_DIR/$CASE_NAME" -lm
+  build_case "$CASE_SOURCE" "$CASE_DIR/$CASE_NAME" -I"$REPO_ROOT/src-local" -O2 -Wall -disable-dimensions ${PRECISION_FLAGS[@]+"${PRECISION_FLAGS[@]}"} ${DEFINES[@]+"${DEFINES[@]}"}
 )
 (
   cd "$CASE_DIR"
-  "./$CASE_NAME"
+  launch_case "./$CASE_NAME" "$@"
 )
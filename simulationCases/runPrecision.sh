@@ -0,0 +1,106 @@
+#!/bin/bash
+# runPrecision.sh - Accuracy and speed of the single/mixed precision builds
+#
+# Description:
+#   Builds <case-name>.c in double, single and mixed precision (see
+#   common.sh), runs the same parameter point with each build in its own
+#   directory, then compares the last common snapshot of the single and
+#   mixed runs with the double-precision one (relative L2 and max
+#   differences, relative change of the dominant wavenumber, see
+#   postProcess/compare_precision.py). The wall time and multigrid cycles
+#   per step of each run are read from its profile.json summary.
+#
+#   Without a control parameter on the command line, the runs are made at
+#   the patterned point of common.sh (brusselator mu=0.1, keller-segel
+#   chi=5): a homogeneous state would agree in all precisions.
+#
+# Usage:
+#   ./runPrecision.sh [-m serial|openmp|mpi] [-n threads|ranks] [-D NAME=VALUE]...
+#                     <case-name> [name=value]...
+#
+#   e.g. ./runPrecision.sh -m openmp -n 8 brusselator mu=0.1 N=512 nsteps=2000
+#
+# Outputs:
+#   simulationCases/<case>/precision/<double|single|mixed>/   outputs of each run
+#   simulationCases/<case>/precision/comparison.tsv
+
+set -euo pipefail
+
+usage() {
+  echo "Usage: $0 [-m serial|openmp|mpi] [-n threads|ranks] [-D NAME=VALUE]..." \
+    "<case-name> [name=value]..." >&2
+  exit 1
+}
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+# shellcheck source=common.sh
+source "$SCRIPT_DIR/common.sh"
+
+MODE="serial"
+NP=1
+DEFINES=()
+while getopts "m:n:D:h" opt; do
+  case "$opt" in
+    m) MODE="$OPTARG" ;;
+    n) NP="$OPTARG" ;;
+    D) DEFINES+=("-D$OPTARG") ;;
+    *) usage ;;
+  esac
+done
+shift $((OPTIND - 1))
+check_mode || usage
+
+if [[ -z "${1:-}" ]]; then
+  usage
+fi
+
+CASE_NAME="$1"
+shift
+point=$(case_point "$CASE_NAME") || usage
+if [[ " $* " != *" ${point%%=*}="* ]]; then
+  set -- "$point" "$@"
+  echo "Running at $point" >&2
+fi
+REPO_ROOT=$(cd "$SCRIPT_DIR/.." && pwd)
+PRECISION_DIR="$SCRIPT_DIR/$CASE_NAME/precision"
+CASE_SOURCE="$SCRIPT_DIR/$CASE_NAME.c"
+
+mkdir -p "$PRECISION_DIR"
+TIMING="$PRECISION_DIR/timing.tsv"
+printf "precision\twall\tmg1_per_step\tmg2_per_step\n" > "$TIMING"
+
+for precision in double single mixed; do
+  run_dir="$PRECISION_DIR/$precision"
+  rm -rf "$run_dir"
+  mkdir -p "$run_dir"
+  read -r -a flags <<< "$(precision_flags "$precision")"
+  (
+    cd "$REPO_ROOT"
+    build_case "$CASE_SOURCE" "$run_dir/$CASE_NAME" -I"$REPO_ROOT/src-local" -O2 -Wall -disable-dimensions \
+      ${flags[@]+"${flags[@]}"} ${DEFINES[@]+"${DEFINES[@]}"}
+  )
+  echo "Running $CASE_NAME in $precision precision" >&2
+  status=0
+  (
+    cd "$run_dir"
+    launch_case "./$CASE_NAME" chkwall=0 "$@" > out 2> log
+  ) || status=$?
+  if [[ $status -ne 0 || ! -s "$run_dir/profile.json" ]]; then
+    echo "  failed (status $status), see $run_dir/log" >&2
+    exit 1
+  fi
+  tail -n 1 "$run_dir/profile.json" > "$run_dir/summary.json"
+  printf "%s\t%s\t%s\t%s\n" "$precision" \
+    "$(json_value "$run_dir/summary.json" "" wall)" \
+    "$(json_value "$run_dir/summary.json" mg1 cycles_per_step)" \
+    "$(json_value "$run_dir/summary.json" mg2 cycles_per_step)" >> "$TIMING"
+done
+
+COMPARISON="$PRECISION_DIR/comparison.tsv"
+{
+  cat "$TIMING"
+  echo
+  python3 "$REPO_ROOT/postProcess/compare_precision.py" "$PRECISION_DIR/double/snapshots.bin" \
+    single="$PRECISION_DIR/single/snapshots.bin" mixed="$PRECISION_DIR/mixed/snapshots.bin"
+} > "$COMPARISON"
+cat "$COMPARISON"
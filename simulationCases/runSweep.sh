@@ -0,0 +1,255 @@
+#!/bin/bash
+# runSweep.sh - Run a case concurrently over a list or grid of parameters
+#
+# Description:
+#   Compiles <case-name>.c once, then runs one independent simulation per
+#   parameter point, each in its own directory, with up to <jobs> runs at
+#   a time. Exit status, wall time, number of steps, solver speed and
+#   settling time (when a run stopped on a steady state, see
+#   src-local/steady.h) of every run are gathered into a single summary
+#   table.
+#
+#   With -e M, each point is run as an ensemble of M realisations which
+#   differ only by the random perturbation of their initial conditions
+#   (member=0..M-1, see src-local/rng.h), and the mean and standard
+#   deviation over the members of the last row of their diagnostics.csv
+#   are gathered into a second table.
+#
+# Usage:
+#   ./runSweep.sh [-j jobs] [-o name] [-f points-file] [-e members] [-m serial|openmp|mpi]
+#                 [-n threads|ranks] [-D NAME=VALUE]... <case-name> [name=v1,v2,...]...
+#
+# Options:
+#   -j jobs         Maximum number of concurrent runs (default: number of cores / np)
+#   -o name         Sweep name (default: sweep)
+#   -f points-file  Read additional points, one per line (e.g. "mu=0.1 D=8")
+#   -e members      Run each point as an ensemble of this many members
+#   -m mode         Parallel mode of each run: serial (default), openmp or mpi
+#   -n np           OpenMP threads or MPI ranks of each run (default: 1)
+#   -D NAME=VALUE   Compile-time option of the case (e.g. -D COUPLED=1)
+#
+#   Up to jobs x np cores are used at a time.
+#
+#   Each name=v1,v2,... argument adds one axis to the grid of points: the
+#   sweep covers the Cartesian product of all axes, e.g.
+#     ./runSweep.sh brusselator mu=0.04,0.1,0.98 D=8,10
+#
+# Outputs:
+#   simulationCases/<case>/<name>/<point>/   outputs, out and log of each run
+#   simulationCases/<case>/<name>/summary.tsv
+#   simulationCases/<case>/<name>/ensemble.tsv   (with -e)
+
+set -euo pipefail
+
+usage() {
+  echo "Usage: $0 [-j jobs] [-o name] [-f points-file] [-e members] [-m serial|openmp|mpi] [-n threads|ranks]" \
+    "[-D NAME=VALUE]... <case-name> [name=v1,v2,...]..." >&2
+  exit 1
+}
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+# shellcheck source=common.sh
+source "$SCRIPT_DIR/common.sh"
+
+JOBS=""
+SWEEP_NAME="sweep"
+POINTS_FILE=""
+MEMBERS=0
+MODE="serial"
+NP=1
+DEFINES=()
+
+while getopts "j:o:f:e:m:n:D:h" opt; do
+  case "$opt" in
+    j) JOBS="$OPTARG" ;;
+    o) SWEEP_NAME="$OPTARG" ;;
+    f) POINTS_FILE="$OPTARG" ;;
+    e) MEMBERS="$OPTARG" ;;
+    m) MODE="$OPTARG" ;;
+    n) NP="$OPTARG" ;;
+    D) DEFINES+=("-D$OPTARG") ;;
+    *) usage ;;
+  esac
+done
+shift $((OPTIND - 1))
+check_mode || usage
+if [[ ! "$MEMBERS" =~ ^[0-9]+$ ]]; then
+  echo "Invalid number of ensemble members '$MEMBERS'" >&2
+  usage
+fi
+if [[ -z "$JOBS" ]]; then
+  JOBS=$(( $(nproc 2>/dev/null || echo 1) / NP ))
+  (( JOBS >= 1 )) || JOBS=1
+fi
+
+if [[ -z "${1:-}" ]]; then
+  usage
+fi
+
+CASE_NAME="$1"
+shift
+REPO_ROOT=$(cd "$SCRIPT_DIR/.." && pwd)
+CASE_DIR="$SCRIPT_DIR/$CASE_NAME"
+CASE_SOURCE="$SCRIPT_DIR/$CASE_NAME.c"
+SWEEP_DIR="$CASE_DIR/$SWEEP_NAME"
+
+# Build the list of points: the Cartesian product of the axes given on
+# the command line, followed by the points read from the points file.
+POINTS=()
+if [[ $# -gt 0 ]]; then
+  POINTS=("")
+  for axis in "$@"; do
+    name="${axis%%=*}"
+    values="${axis#*=}"
+    if [[ "$axis" != *=* || -z "$name" || -z "$values" ]]; then
+      echo "Malformed parameter axis '$axis' (expected name=v1,v2,...)" >&2
+      exit 1
+    fi
+    IFS=',' read -r -a vals <<< "$values"
+    grid=()
+    for point in "${POINTS[@]}"; do
+      for value in "${vals[@]}"; do
+        grid+=("${point:+$point }$name=$value")
+      done
+    done
+    POINTS=("${grid[@]}")
+  done
+fi
+if [[ -n "$POINTS_FILE" ]]; then
+  while read -r line; do
+    [[ -z "$line" || "$line" == \#* ]] && continue
+    POINTS+=("$line")
+  done < "$POINTS_FILE"
+fi
+if [[ ${#POINTS[@]} -eq 0 ]]; then
+  echo "No parameter points given" >&2
+  usage
+fi
+
+# Expand each point into the members of its ensemble.
+BASE_POINTS=("${POINTS[@]}")
+if (( MEMBERS > 0 )); then
+  POINTS=()
+  for point in "${BASE_POINTS[@]}"; do
+    for ((k = 0; k < MEMBERS; k++)); do
+      POINTS+=("$point member=$k")
+    done
+  done
+fi
+
+mkdir -p "$SWEEP_DIR"
+cp "$CASE_SOURCE" "$CASE_DIR/"
+
+(
+  cd "$REPO_ROOT"
+  build_case "$CASE_SOURCE" "$SWEEP_DIR/$CASE_NAME" -I"$REPO_ROOT/src-local" -O2 -Wall -disable-dimensions ${DEFINES[@]+"${DEFINES[@]}"}
+)
+
+# Runs a single point in its own directory and records one summary line
+# (directory, status, wall time, steps, speed, settling time, parameters)
+# in status.tsv.
+run_point() {
+  local point="$1" dir="$2"
+  local start end status timing settled
+  mkdir -p "$SWEEP_DIR/$dir"
+  cd "$SWEEP_DIR/$dir"
+  start=$(date +%s.%N)
+  status=0
+  # shellcheck disable=SC2086  # the point is a list of name=value words
+  launch_case "$SWEEP_DIR/$CASE_NAME" $point > out 2> log || status=$?
+  end=$(date +%s.%N)
+  # Basilisk reports "# <grid>, <n> steps, ..., <speed> points.step/s, ..."
+  timing=$(awk -F ', ' '/^# .* steps, .* points\.step\/s/ {
+    split ($2, n, " "); split ($5, v, " "); last = n[1] "\t" v[1] }
+    END { print (last == "" ? "-\t-" : last) }' out)
+  settled=$(awk -F ',' 'NR > 1 { s = $1 } END { print (s == "" ? "-" : s) }' \
+    steady.csv 2>/dev/null || echo "-")
+  printf "%s\t%d\t%s\t%s\t%s\t%s\n" "$dir" "$status" \
+    "$(awk -v s="$start" -v e="$end" 'BEGIN { printf "%.2f", e - s }')" \
+    "$timing" "$settled" "$point" > status.tsv
+}
+
+echo "Running ${#POINTS[@]} points of $CASE_NAME with up to $JOBS concurrent jobs ($MODE, $NP each) in $SWEEP_DIR"
+
+DIRS=()
+running=0
+for point in "${POINTS[@]}"; do
+  dir=$(echo "$point" | tr ' =' '_-')
+  DIRS+=("$dir")
+  if (( running >= JOBS )); then
+    wait -n || true
+    running=$((running - 1))
+  fi
+  run_point "$point" "$dir" &
+  running=$((running + 1))
+done
+wait
+
+SUMMARY="$SWEEP_DIR/summary.tsv"
+failed=0
+{
+  printf "directory\tstatus\twall(s)\tsteps\tpoints.step/s\tsettled(t)\tparameters\n"
+  for dir in "${DIRS[@]}"; do
+    if [[ -f "$SWEEP_DIR/$dir/status.tsv" ]]; then
+      cat "$SWEEP_DIR/$dir/status.tsv"
+      [[ $(cut -f 2 "$SWEEP_DIR/$dir/status.tsv") == 0 ]] || failed=$((failed + 1))
+    else
+      printf "%s\t-\t-\t-\t-\t-\t-\n" "$dir"
+      failed=$((failed + 1))
+    fi
+  done
+} > "$SUMMARY"
+
+cat "$SUMMARY"
+
+# Ensemble statistics: for each base point, the mean and (sample)
+# standard deviation over its members of each column of the last row of
+# diagnostics.csv (i.e. the last diagnostics of the last run).
+if (( MEMBERS > 0 )); then
+  ENSEMBLE="$SWEEP_DIR/ensemble.tsv"
+  header=""
+  for point in "${BASE_POINTS[@]}"; do
+    files=()
+    for ((k = 0; k < MEMBERS; k++)); do
+      file="$SWEEP_DIR/$(echo "$point member=$k" | tr ' =' '_-')/diagnostics.csv"
+      [[ -f "$file" ]] && files+=("$file")
+    done
+    (( ${#files[@]} > 0 )) || continue
+    [[ -n "$header" ]] || header=$(head -n 1 "${files[0]}")
+    awk -F ',' -v point="$point" '
+      FNR == 1 { next }
+      /^#/ { next }
+      { last[FILENAME] = $0 }
+      END {
+        n = 0
+        for (f in last) {
+          m = split (last[f], v, ",")
+          for (j = 1; j <= m; j++) { s[j] += v[j]; s2[j] += v[j]*v[j] }
+          n++
+        }
+        printf "%s\t%d", point, n
+        for (j = 1; j <= m; j++) {
+          mean = s[j]/n
+          var = n > 1 ? (s2[j] - n*mean*mean)/(n - 1) : 0
+          printf "\t%g\t%g", mean, (var > 0 ? sqrt (var) : 0)
+        }
+        printf "\n"
+      }' "${files[@]}"
+  done > "$ENSEMBLE.tmp"
+  {
+    printf "parameters\tmembers"
+    IFS=',' read -r -a cols <<< "$header"
+    for col in ${cols[@]+"${cols[@]}"}; do
+      printf "\t%s_mean\t%s_sd" "$col" "$col"
+    done
+    printf "\n"
+    cat "$ENSEMBLE.tmp"
+  } > "$ENSEMBLE"
+  rm -f "$ENSEMBLE.tmp"
+  cat "$ENSEMBLE"
+fi
+
+if (( failed > 0 )); then
+  echo "$failed of ${#POINTS[@]} runs failed, see $SUMMARY" >&2
+  exit 1
+fi
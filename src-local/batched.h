@@ -0,0 +1,222 @@
+/**
+# Batched Helmholtz solver for independent instances
+
+A sweep over small grids (e.g. $128^2$) pays, for every point, the
+start-up of a process and the set-up of the solver, and a single
+$128^2$ grid is too small to keep the cores of a node busy. Instead,
+$K$ independent instances of a problem can share a single grid: each
+field of the model becomes $K$ *lanes*, one per instance, and the $K$
+Poisson--Helmholtz problems
+$$
+D_l\nabla^2 a_l + \lambda_l a_l = b_l, \qquad l = 0, \dots, K - 1
+$$
+(with constant diffusion coefficients $D_l$) are solved together with
+the multigrid cycle of [poisson.h](/src/poisson.h).
+
+Each traversal of the multigrid hierarchy (relaxation, residual,
+restriction, prolongation) then updates all the lanes of a cell
+before moving to the next cell, so that the cost of the traversal
+itself (index arithmetic, stencil access, loop overhead) is shared by
+the $K$ instances. All the lanes share the V-cycles until the largest
+residual over all instances is below the tolerance: the statistics
+returned are those of the batch.
+
+The number of lanes `BATCH` is a compile-time constant and the lanes
+of a field are allocated with consecutive indices (see
+`batched_new()`), so that lane $l$ of a list `a` is the field of index
+`a[0].i + l` (see `lane()`). As Basilisk stores the fields of a cell
+next to each other, the loops over the lanes of a cell are then
+unit-stride loops of fixed length. Loops which only read the fields
+and write local arrays (or only write one field) can be vectorised by
+the compiler; a loop which reads the neighbours of a field while
+writing the same field (as in Gauss--Seidel) cannot, as the compiler
+must assume that the stores alias the loads. The smoother below thus
+first computes the new values of all the lanes into a local array,
+then stores them.
+
+With the stand-alone C equivalent of these kernels (one cell of
+$4K$ doubles, $128^2$ cells, gcc 12 `-O2 -fopt-info-vec`), both loops
+of the smoother and the loop computing the residuals are vectorised (SSE2
+by default), and a sweep updates about three times as many cells per
+second for $K = 4$ lanes as four sweeps of one field each; most of
+this comes from sharing the traversal, the vectorisation itself
+changes little.
+
+The relaxation and residual are those of [poisson.h](/src/poisson.h)
+for constant face coefficients, which are thus not read from face
+fields. This is for uniform (multi)grids: on trees, the instances
+would need a common refinement anyway. */
+
+#include "poisson.h"
+
+#if TREE
+# error "batched.h requires a uniform (multi)grid"
+#endif
+#if MIXED_PRECISION
+# error "MIXED_PRECISION is not implemented for batched.h"
+#endif
+
+#ifndef BATCH
+# define BATCH 4
+#endif
+
+/**
+Lane `l` of the batched list `list`. */
+
+#define lane(list, l) ((scalar){(list)[0].i + (l)})
+
+/**
+### batched_new()
+
+Returns a list of `BATCH` new fields named `<name>_<l>`, with
+consecutive indices. The list (and the fields) must be freed with
+`batched_free()`. */
+
+scalar * batched_new (const char * name)
+{
+  scalar * list = NULL;
+  for (int l = 0; l < BATCH; l++) {
+    scalar s = new scalar;
+    char fname[80];
+    snprintf (fname, sizeof (fname), "%s_%d", name, l);
+    free (s.name);
+    s.name = strdup (fname);
+    list = list_append (list, s);
+  }
+  for (int l = 1; l < BATCH; l++)
+    if (list[l].i != list[0].i + l) {
+      fprintf (stderr, "batched_new(): the lanes of '%s' are not contiguous\n",
+	       name);
+      exit (1);
+    }
+  return list;
+}
+
+void batched_free (scalar ** list)
+{
+  delete (*list);
+  free (*list);
+  *list = NULL;
+}
+
+struct Batched {
+  scalar * lambda;
+  const double * D;
+};
+
+/**
+## Relaxation and residual
+
+The Gauss--Seidel relaxation of [poisson.h](/src/poisson.h), applied
+to all the lanes of a cell: the new values are computed first, then
+stored (see above). */
+
+static void batched_relax (scalar * al, scalar * bl, int l, void * data)
+{
+  struct Batched * p = (struct Batched *) data;
+  const double * D = p->D;
+  int a0 = al[0].i, b0 = bl[0].i, l0 = p->lambda[0].i;
+
+  foreach_level_or_leaf (l) {
+    double n[BATCH], d[BATCH];
+    for (int j = 0; j < BATCH; j++) {
+      scalar a = {a0 + j}, b = {b0 + j}, lambda = {l0 + j};
+      n[j] = - sq(Delta)*b[], d[j] = 2.*dimension*D[j] - lambda[]*sq(Delta);
+      foreach_dimension()
+	n[j] += D[j]*(a[1] + a[-1]);
+    }
+    for (int j = 0; j < BATCH; j++) {
+      scalar a = {a0 + j};
+      a[] = n[j]/d[j];
+    }
+  }
+}
+
+static double batched_residual (scalar * al, scalar * bl, scalar * resl,
+				void * data)
+{
+  struct Batched * p = (struct Batched *) data;
+  const double * D = p->D;
+  int a0 = al[0].i, b0 = bl[0].i, r0 = resl[0].i, l0 = p->lambda[0].i;
+  double maxres = 0.;
+
+  foreach (reduction(max:maxres)) {
+    double r[BATCH];
+    for (int j = 0; j < BATCH; j++) {
+      scalar a = {a0 + j}, b = {b0 + j}, lambda = {l0 + j};
+      r[j] = b[] - lambda[]*a[];
+      foreach_dimension()
+	r[j] -= D[j]*(a[1] - 2.*a[] + a[-1])/sq(Delta);
+    }
+    for (int j = 0; j < BATCH; j++) {
+      scalar res = {r0 + j};
+      res[] = r[j];
+      if (fabs (r[j]) > maxres)
+	maxres = fabs (r[j]);
+    }
+  }
+  return maxres;
+}
+
+/**
+## User interface
+
+Solves the problems of all the lanes of `a`, with right-hand sides
+`b`, diagonal coefficients `lambda` and diffusion coefficients `D` (an
+array of `BATCH` entries). All the lists must come from
+`batched_new()`; the optional `res` list holds the residuals. */
+
+mgstats batched_helmholtz (scalar * a, scalar * b, scalar * lambda,
+			   const double * D,
+			   double tolerance = 0.,
+			   int nrelax = 4,
+			   int minlevel = 0,
+			   scalar * res = NULL)
+{
+  restriction (lambda);
+  struct Batched p = { lambda, D };
+  if (!tolerance)
+    tolerance = TOLERANCE;
+
+  /**
+  The lanes of the correction `da` and of the residual must be
+  contiguous as well, so that the iterations of `mg_solve()` are
+  repeated here with lists from `batched_new()` rather than from
+  `list_clone()`. As in `mg_solve()`, the correction has the
+  homogeneous boundary conditions of `a`. */
+
+  scalar * da = batched_new ("da"), * r = res ? res : batched_new ("res");
+  for (int l = 0; l < BATCH; l++) {
+    scalar s = lane (da, l), sa = lane (a, l);
+    for (int d = 0; d < nboundary; d++)
+      s.boundary[d] = sa.boundary_homogeneous[d];
+  }
+
+  mgstats s = {0};
+  s.nrelax = nrelax > 0 ? nrelax : 1;
+  s.minlevel = max(1, minlevel);
+  s.resb = s.resa = batched_residual (a, b, r, &p);
+  double resb = s.resb;
+  for (s.i = 0; s.i < NITERMAX && (s.i < NITERMIN || s.resa > tolerance);
+       s.i++) {
+    mg_cycle (a, r, da, batched_relax, &p, s.nrelax, s.minlevel,
+	      grid->maxdepth);
+    s.resa = batched_residual (a, b, r, &p);
+    if (s.resa > tolerance) {
+      if (resb/s.resa < 1.2 && s.nrelax < 100)
+	s.nrelax++;
+      else if (resb/s.resa > 10 && s.nrelax > 2)
+	s.nrelax--;
+    }
+    resb = s.resa;
+  }
+  if (s.resa > tolerance)
+    fprintf (stderr,
+	     "WARNING: convergence for %s not reached after %d iterations\n"
+	     "  res: %g\n", a[0].name, s.i, s.resa);
+
+  batched_free (&da);
+  if (!res)
+    batched_free (&r);
+  return s;
+}
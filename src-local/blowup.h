@@ -0,0 +1,167 @@
+/**
+# Blow-up monitor for chemotactic collapse
+
+Above the critical mass $M_c = 8\pi/\chi$, the density of the 2D
+Keller--Segel model concentrates into a point in finite time. On a
+given grid the collapse is only resolved until the aggregate shrinks
+to a few cells, after which the solution is meaningless (or, for
+schemes without a positivity guarantee, not even finite).
+
+The monitor is called every step with
+
+* the maximum density $\rho_\text{max}$,
+* the total mass $M = \int\rho$,
+* the maximum of $|\nabla c|$,
+* the largest mass held by a single cell, $\max \rho\,\Delta^2$,
+
+which the case computes within a sweep over the grid which it does
+anyway (e.g. for its [diagnostics](diagnostics.h)).
+
+The state is *invalid* when the mass is not finite (i.e. $\rho$ holds
+NaNs or infinities) or has drifted from its initial value by more
+than the scheme can explain. The fluxes of the finite-volume and
+spectral schemes conserve the mass exactly, but the implicit solves
+only do so up to their residual: a step of size $\Delta t$ whose
+residual is at most $r$ changes the mass by at most
+$r\,\Delta t\,|\Omega|$. The case passes this bound at every check,
+and the drift allowed is the sum of these bounds plus a relative
+`blowup_mass`. The aggregate is *unresolved* when a single cell holds
+more than a fraction `blowup_cell` of the critical mass.
+
+The blow-up time $T$ is estimated by extrapolating $1/\rho_\text{max}$,
+which decreases roughly linearly as $t \to T$, to zero from its last
+two values.
+
+What is done about an unresolved aggregate depends on `blowup_action`:
+
+* `BLOWUP_STOP` (0): stop the run.
+* `BLOWUP_SHRINK` (1): from the start, also limit the timestep so that
+  $\rho_\text{max}$ grows by at most a fraction `blowup_growth` per
+  step (see `blowup_dtmax()`), then stop when unresolved.
+* `BLOWUP_REFINE` (2): on an adaptive grid, ask the case to raise the
+  maximum level of refinement by one (which divides the cell mass of
+  the aggregate by four once it is refined), at most `blowup_levels`
+  times, then stop. The timestep is limited as for `BLOWUP_SHRINK`.
+
+A run which stops is logged on standard error and appended to
+`blowup.csv`, with the blow-up time estimate and the parameters of the
+run. */
+
+#include "parameters.h"
+
+enum { BLOWUP_STOP, BLOWUP_SHRINK, BLOWUP_REFINE };
+enum { BLOWUP_NONE = - 1 };
+
+int blowup_action = BLOWUP_STOP, blowup_levels = 3;
+double blowup_cell = 0.1, blowup_mass = 1e-3, blowup_growth = 0.1;
+
+static struct {
+  double t, rhomax, mass0, dtmax, drift;
+  int levels;
+  bool valid;
+} blowup;
+
+event blowup_reset (i = 0)
+{
+  blowup.t = - 1.;
+  blowup.mass0 = 0.;
+  blowup.dtmax = HUGE;
+  blowup.drift = 0.;
+  blowup.levels = 0;
+  blowup.valid = true;
+}
+
+/**
+### blowup_dtmax()
+
+The maximum timestep allowed by the growth of $\rho_\text{max}$
+(`HUGE` with `BLOWUP_STOP`). */
+
+double blowup_dtmax (void)
+{
+  return blowup_action == BLOWUP_STOP ? HUGE : blowup.dtmax;
+}
+
+/**
+### blowup_valid()
+
+Whether the state which made the run stop is still finite and
+conservative, i.e. worth saving. */
+
+bool blowup_valid (void)
+{
+  return blowup.valid;
+}
+
+static void blowup_log (const char * reason, double rhomax, double mass,
+			double grad, double cell, double T, Parameter * params)
+{
+  if (pid() > 0)
+    return;
+  fprintf (stderr, "blowup: %s at t = %g, i = %d: max rho = %g, mass = %g, "
+	   "max |grad c| = %g, estimated blow-up time %g\n",
+	   reason, t, i, rhomax, mass, grad, T);
+  FILE * fp = fopen ("blowup.csv", "a");
+  if (!fp) {
+    perror ("blowup.csv");
+    exit (1);
+  }
+  if (ftell (fp) == 0)
+    fputs ("reason,t,i,rho_max,mass,grad_c_max,cell_mass,t_blowup,"
+	   "parameters\n", fp);
+  fprintf (fp, "%s,%g,%d,%g,%g,%g,%g,%g,", reason, t, i, rhomax, mass,
+	   grad, cell, T);
+  print_parameters (fp, params);
+  fclose (fp);
+}
+
+/**
+### blowup_check()
+
+Checks the state given by the quantities above, for the critical mass
+`mc`, where `solver` bounds the change of mass made by the solves of
+the last step. Returns `BLOWUP_STOP` when the run must stop, `BLOWUP_REFINE`
+when the case must raise its maximum level of refinement, and
+`BLOWUP_NONE` otherwise. */
+
+int blowup_check (double rhomax, double mass, double grad, double cell,
+		  double mc, Parameter * params, double solver = 0.)
+{
+  /**
+  The blow-up time estimate and the growth rate of $\rho_\text{max}$
+  use the previous call (of the same run). */
+
+  double T = HUGE;
+  if (blowup.t >= 0. && t > blowup.t && rhomax > 0.) {
+    double slope = (1./rhomax - 1./blowup.rhomax)/(t - blowup.t);
+    if (slope < 0.)
+      T = t - 1./(rhomax*slope);
+    double growth = (rhomax - blowup.rhomax)/((t - blowup.t)*rhomax);
+    blowup.dtmax = growth > 0. ? blowup_growth/growth : HUGE;
+  }
+  if (blowup.mass0 == 0.)
+    blowup.mass0 = mass;
+  else
+    blowup.drift += solver;
+  blowup.t = t, blowup.rhomax = rhomax;
+
+  if (!isfinite (mass) || fabs (mass - blowup.mass0) >
+      blowup_mass*fabs (blowup.mass0) + blowup.drift) {
+    blowup.valid = false;
+    blowup_log ("invalid", rhomax, mass, grad, cell, T, params);
+    return BLOWUP_STOP;
+  }
+  if (cell <= blowup_cell*mc)
+    return BLOWUP_NONE;
+#if TREE
+  if (blowup_action == BLOWUP_REFINE && blowup.levels < blowup_levels) {
+    blowup.levels++;
+    if (pid() == 0)
+      fprintf (stderr, "blowup: unresolved at t = %g (max rho = %g), "
+	       "refining (%d/%d)\n", t, rhomax, blowup.levels, blowup_levels);
+    return BLOWUP_REFINE;
+  }
+#endif
+  blowup_log ("unresolved", rhomax, mass, grad, cell, T, params);
+  return BLOWUP_STOP;
+}
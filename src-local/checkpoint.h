@@ -0,0 +1,289 @@
+/**
+# Checkpoint and restart
+
+Long runs are periodically checkpointed so that a killed (or
+preempted) job can resume where it stopped instead of starting again
+from $t = 0$.
+
+A checkpoint is made of a Basilisk [dump](/src/output.h#dump) of the
+fields and of a text file `<name>.info`. Its first line records the
+time, iteration, last timestep, the size in bytes of the field values
+(`real=4` with `-DSINGLE_PRECISION=1`, 8 otherwise, since dumps cannot
+be restored with another precision), the number of fields dumped and
+the current run parameters as `name=value` pairs. Its second line
+records the parameters the run was started with.
+To remain valid if the job is killed while writing, the dumps alternate
+between the two slots `<name>-0.dump` and `<name>-1.dump`: the new dump
+is completed before the info file, which designates the valid slot, is
+atomically replaced (written to a temporary file then renamed).
+
+The random perturbations of the initial conditions are the only use of
+random numbers. They are drawn from the stateless, counter-based
+generator of [rng.h](rng.h) and are skipped on restart anyway, so that
+there is no generator state to save.
+
+A case typically does
+
+~~~literatec
+event init (i = 0)
+{
+  sprintf (checkpoint_name, "checkpoint-chi-%g", chi);
+  if (!restart ({rho, c}, params, &dt))
+    foreach()
+      ...
+}
+
+event checkpoints (i++)
+{
+  if (checkpoint_due())
+    checkpoint ({rho, c}, params, dt);
+}
+~~~
+
+where the `checkpoints` event must come before the integration event,
+so that the fields are saved at time `t`. Note that the outputs written
+between the last checkpoint and the interruption (e.g. the frames of a
+[snapshot](snapshot.h) stream) are written again after the restart. */
+
+#include "parameters.h"
+
+/**
+The checkpoint is written every `checkpoint_steps` iterations and/or
+every `checkpoint_wall` seconds of wall-clock time (a zero value
+disables the corresponding criterion). Cases name it after their
+control parameter, and [restart()](#restart) appends a hash of all the
+parameters of the run, so that runs which differ by any parameter
+(e.g. `D=2` after a killed `D=1` run) do not share a checkpoint.
+
+The parameters listed in `checkpoint_free` only control how a run is
+carried out, and can be changed when it is resumed, e.g. a smaller
+`dtmax` to get past an instability: they are left out of the hash and
+of the comparison below, and keep their command-line values. */
+
+double checkpoint_wall = 900.;
+int checkpoint_steps = 0;
+char checkpoint_name[80] = "checkpoint";
+const char * checkpoint_free[] = {
+  "dtmax", "dttol", "nsteps", "chkwall", "chksteps", "diagevery", NULL
+};
+
+static timer checkpoint_timer;
+static int checkpoint_slot = 1, checkpoint_last = -1;
+static bool checkpoint_finished = false;
+static char checkpoint_params[4096];
+
+/**
+The parameters are hashed with 32-bit FNV-1a. */
+
+static unsigned checkpoint_hash (const char * s)
+{
+  unsigned h = 2166136261u;
+  for (; *s; s++)
+    h = (h ^ (unsigned char) *s)*16777619u;
+  return h;
+}
+
+static bool checkpoint_is_free (const char * name)
+{
+  for (const char ** p = checkpoint_free; *p; p++)
+    if (!strcmp (*p, name))
+      return true;
+  return false;
+}
+
+/**
+### restart()
+
+Appends the hash of the parameters of the table to `checkpoint_name`
+and, if there is a checkpoint of this name, restores the fields of
+`list`, `t`, `i`, the timestep and the parameters of the table from it
+and returns `true`. It also starts the wall-clock timer of the
+checkpoints, so it must be called once at the start of every run,
+after the parameters have been set.
+
+The checkpoint is only used if it was started with exactly the
+parameters of this run and has the same fields: otherwise the run
+stops, rather than either silently continuing another parameter point
+or discarding the checkpoint of another run. The parameters restored
+are thus those of the command line, except for those changed by the
+run itself (e.g. the `maxlevel` raised by the [blow-up
+monitor](blowup.h)), and the free parameters are not restored. The
+[baked parameters](parameters.h#baked-parameters) are hashed, compared
+and read like the others, so that a build which bakes a parameter
+resumes the checkpoint of an unbaked run with the same value, and
+stops on one with another value. */
+
+bool restart (scalar * list, Parameter * params, double * dt)
+{
+  checkpoint_timer = timer_start();
+  checkpoint_slot = 1;
+  checkpoint_last = -1;
+  checkpoint_finished = false;
+
+  int np = 0, nk = 0;
+  while (params[np].name)
+    np++;
+  Parameter keyed[np + 1];
+  for (int n = 0; n <= np; n++)
+    if (!params[n].name || !checkpoint_is_free (params[n].name))
+      keyed[nk++] = params[n];
+  FILE * fp = fmemopen (checkpoint_params, sizeof (checkpoint_params), "w");
+  print_parameters (fp, keyed, "%.17g");
+  fclose (fp);
+  char key[12];
+  sprintf (key, "-%08x", checkpoint_hash (checkpoint_params));
+  strncat (checkpoint_name, key,
+	   sizeof (checkpoint_name) - strlen (checkpoint_name) - 1);
+
+  char info[100], line[4096], started[4096];
+  sprintf (info, "%s.info", checkpoint_name);
+  fp = fopen (info, "r");
+  if (!fp)
+    return false;
+  if (!fgets (line, sizeof (line), fp) ||
+      !fgets (started, sizeof (started), fp)) {
+    fprintf (stderr, "%s: incomplete checkpoint\n", info);
+    exit (1);
+  }
+  fclose (fp);
+  if (strcmp (started, checkpoint_params)) {
+    fprintf (stderr, "%s: started with the parameters\n  %s"
+	     "instead of\n  %s(remove the checkpoint to start afresh)\n",
+	     info, started, checkpoint_params);
+    exit (1);
+  }
+
+  /**
+  The info line is parsed with [read_parameters()](parameters.h),
+  using a table which extends the parameters of the case with the
+  state of the run. The values of the free parameters are discarded. */
+
+  int slot = 0, bytes = 8, nf = list_len (list), fields = nf, idiscard;
+  double discard;
+  Parameter table[np + 7];
+  table[0] = (Parameter){"slot", NULL, &slot};
+  table[1] = (Parameter){"t", &t};
+  table[2] = (Parameter){"i", NULL, &i};
+  table[3] = (Parameter){"dt", dt};
+  table[4] = (Parameter){"real", NULL, &bytes};
+  table[5] = (Parameter){"fields", NULL, &fields};
+  for (int n = 0; n <= np; n++)
+    table[6 + n] = params[n];
+  for (int n = 0; n < np; n++)
+    if (checkpoint_is_free (params[n].name)) {
+      Parameter * p = &table[6 + n];
+      if (p->ivalue)
+	p->ivalue = &idiscard;
+      else
+	p->value = &discard;
+    }
+
+  char * argv[np + 8];
+  int argc = 0;
+  argv[argc++] = info;
+  for (char * s = strtok (line, " \n"); s && argc < np + 8;
+       s = strtok (NULL, " \n"))
+    argv[argc++] = s;
+
+  read_parameters (argc, argv, table);
+  if (bytes != sizeof (real)) {
+    fprintf (stderr, "%s: written with %d-byte fields, this build uses %d "
+	     "(remove the checkpoint or rebuild with the same precision)\n",
+	     info, bytes, (int) sizeof (real));
+    exit (1);
+  }
+  if (fields != nf) {
+    fprintf (stderr, "%s: written with %d fields, this build has %d "
+	     "(remove the checkpoint or rebuild with the same options)\n",
+	     info, fields, nf);
+    exit (1);
+  }
+  double t0 = t;
+  int i0 = i;
+  char file[100];
+  sprintf (file, "%s-%d.dump", checkpoint_name, slot);
+  if (!restore (file = file, list = list)) {
+    fprintf (stderr, "%s: cannot restore '%s'\n", info, file);
+    exit (1);
+  }
+  t = t0, i = i0;
+  checkpoint_slot = slot;
+  checkpoint_last = i;
+  if (pid() == 0)
+    fprintf (stderr, "restarting from '%s' at t = %g, i = %d\n", file, t, i);
+  return true;
+}
+
+/**
+### checkpoint_due()
+
+Returns `true` when a checkpoint should be written at this iteration.
+The wall-clock criterion is decided by the root process, so that all
+the processes take part in the (collective) dump. */
+
+bool checkpoint_due (void)
+{
+  if (checkpoint_finished || i == 0 || i == checkpoint_last)
+    return false;
+  int due = (checkpoint_steps > 0 && i % checkpoint_steps == 0) ||
+    (checkpoint_wall > 0. && timer_elapsed (checkpoint_timer) > checkpoint_wall);
+#if _MPI
+  MPI_Bcast (&due, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+  return due;
+}
+
+/**
+### checkpoint()
+
+Writes the fields of `list` to the slot which does not hold the
+current checkpoint, then switches the info file to this slot. */
+
+void checkpoint (scalar * list, Parameter * params, double dt)
+{
+  int slot = 1 - checkpoint_slot;
+  char file[100], info[100], tmp[104];
+  sprintf (file, "%s-%d.dump", checkpoint_name, slot);
+  dump (file = file, list = list);
+
+  if (pid() == 0) {
+    sprintf (info, "%s.info", checkpoint_name);
+    sprintf (tmp, "%s.tmp", info);
+    FILE * fp = fopen (tmp, "w");
+    if (!fp) {
+      perror (tmp);
+      exit (1);
+    }
+    fprintf (fp, "slot=%d t=%.17g i=%d dt=%.17g real=%d fields=%d", slot, t,
+	     i, dt, (int) sizeof (real), list_len (list));
+    fputc (' ', fp);
+    print_parameters (fp, params, "%.17g");
+    fputs (checkpoint_params, fp);
+    if (fclose (fp) || rename (tmp, info))
+      perror (info);
+  }
+  checkpoint_slot = slot;
+  checkpoint_last = i;
+  checkpoint_timer = timer_start();
+}
+
+/**
+### checkpoint_done()
+
+Removes the checkpoint once the run has completed, so that running the
+case again starts from the beginning, and disables further checkpoints
+for this run. */
+
+void checkpoint_done (void)
+{
+  checkpoint_finished = true;
+  if (pid() == 0) {
+    char name[100];
+    sprintf (name, "%s.info", checkpoint_name);
+    remove (name);
+    for (int slot = 0; slot < 2; slot++) {
+      sprintf (name, "%s-%d.dump", checkpoint_name, slot);
+      remove (name);
+    }
+  }
+}
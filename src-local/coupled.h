@@ -0,0 +1,221 @@
+/**
+# Coupled multigrid solver for two species
+
+We solve the $2\times 2$ block system of Poisson--Helmholtz equations
+$$
+\nabla\cdot(\alpha_{11}\nabla a_1) + \nabla\cdot(\alpha_{12}\nabla a_2)
++ \lambda_{11} a_1 + \lambda_{12} a_2 = b_1
+$$
+$$
+\nabla\cdot(\alpha_{21}\nabla a_1) + \nabla\cdot(\alpha_{22}\nabla a_2)
++ \lambda_{21} a_1 + \lambda_{22} a_2 = b_2
+$$
+for both unknowns at once with the generic multigrid solver of
+[poisson.h](/src/poisson.h), instead of solving the two equations one
+after the other with lagged coupling terms. Each equation follows the
+sign conventions of the Poisson--Helmholtz solver: the implicit
+diffusion of $a_i$ over a timestep $dt$ contributes $-1/dt$ to
+$\lambda_{ii}$.
+
+The smoother is a point-block Gauss--Seidel relaxation: in each cell,
+the $2\times 2$ system coupling the two unknowns (with neighbouring
+values fixed) is solved exactly. The off-diagonal face coefficients
+$\alpha_{12}$ and $\alpha_{21}$ allow cross-diffusion terms, such as
+the implicit chemotactic flux of the Keller--Segel model.
+
+With `-DSINGLE_PRECISION=1`, the tolerance is raised to the rounding
+floor of the residual, as for
+[helmholtz.h](helmholtz.h#single-and-mixed-precision). There is no
+mixed precision version of this solver. */
+
+#include <float.h>
+#include "poisson.h"
+
+#if MIXED_PRECISION
+# error "MIXED_PRECISION is not implemented for coupled.h"
+#endif
+
+struct Coupled {
+  (const) face vector alpha11, alpha12, alpha21, alpha22;
+  (const) scalar lambda11, lambda12, lambda21, lambda22;
+};
+
+/**
+## Relaxation and residual
+
+The relaxation function mirrors that of [poisson.h](/src/poisson.h)
+for each block entry. With $n_i$ the contribution of the neighbours
+and $d_{ij}$ the diagonal coefficients (both scaled by $\Delta^2$), the
+new cell values are the solution of $d_{ij} a_j = n_i$. */
+
+static void coupled_relax (scalar * al, scalar * bl, int l, void * data)
+{
+  scalar a1 = al[0], a2 = al[1], b1 = bl[0], b2 = bl[1];
+  struct Coupled * p = (struct Coupled *) data;
+  (const) face vector alpha11 = p->alpha11, alpha12 = p->alpha12;
+  (const) face vector alpha21 = p->alpha21, alpha22 = p->alpha22;
+  (const) scalar lambda11 = p->lambda11, lambda12 = p->lambda12;
+  (const) scalar lambda21 = p->lambda21, lambda22 = p->lambda22;
+
+  foreach_level_or_leaf (l) {
+    double n1 = - sq(Delta)*b1[], n2 = - sq(Delta)*b2[];
+    double d11 = - lambda11[]*sq(Delta), d12 = - lambda12[]*sq(Delta);
+    double d21 = - lambda21[]*sq(Delta), d22 = - lambda22[]*sq(Delta);
+    foreach_dimension() {
+      n1 += (alpha11.x[1]*a1[1] + alpha11.x[]*a1[-1] +
+	     alpha12.x[1]*a2[1] + alpha12.x[]*a2[-1]);
+      n2 += (alpha21.x[1]*a1[1] + alpha21.x[]*a1[-1] +
+	     alpha22.x[1]*a2[1] + alpha22.x[]*a2[-1]);
+      d11 += alpha11.x[1] + alpha11.x[];
+      d12 += alpha12.x[1] + alpha12.x[];
+      d21 += alpha21.x[1] + alpha21.x[];
+      d22 += alpha22.x[1] + alpha22.x[];
+    }
+    double det = d11*d22 - d12*d21;
+    a1[] = (d22*n1 - d12*n2)/det;
+    a2[] = (d11*n2 - d21*n1)/det;
+  }
+}
+
+/**
+The residual is computed for both equations in the same sweep, as in
+[poisson.h](/src/poisson.h) (with the conservative face-flux
+discretisation on trees). */
+
+static double coupled_residual (scalar * al, scalar * bl, scalar * resl,
+				void * data)
+{
+  scalar a1 = al[0], a2 = al[1], b1 = bl[0], b2 = bl[1];
+  scalar res1 = resl[0], res2 = resl[1];
+  struct Coupled * p = (struct Coupled *) data;
+  (const) face vector alpha11 = p->alpha11, alpha12 = p->alpha12;
+  (const) face vector alpha21 = p->alpha21, alpha22 = p->alpha22;
+  (const) scalar lambda11 = p->lambda11, lambda12 = p->lambda12;
+  (const) scalar lambda21 = p->lambda21, lambda22 = p->lambda22;
+  double maxres = 0.;
+#if TREE
+  /* conservative coarse/fine discretisation (2nd order) */
+  face vector g1[], g2[];
+  foreach_face() {
+    g1.x[] = (alpha11.x[]*face_gradient_x (a1, 0) +
+	      alpha12.x[]*face_gradient_x (a2, 0));
+    g2.x[] = (alpha21.x[]*face_gradient_x (a1, 0) +
+	      alpha22.x[]*face_gradient_x (a2, 0));
+  }
+  foreach (reduction(max:maxres)) {
+    res1[] = b1[] - lambda11[]*a1[] - lambda12[]*a2[];
+    res2[] = b2[] - lambda21[]*a1[] - lambda22[]*a2[];
+    foreach_dimension() {
+      res1[] -= (g1.x[1] - g1.x[])/Delta;
+      res2[] -= (g2.x[1] - g2.x[])/Delta;
+    }
+    if (fabs (res1[]) > maxres)
+      maxres = fabs (res1[]);
+    if (fabs (res2[]) > maxres)
+      maxres = fabs (res2[]);
+  }
+#else
+  /* "naive" discretisation (only 1st order on trees) */
+  foreach (reduction(max:maxres)) {
+    res1[] = b1[] - lambda11[]*a1[] - lambda12[]*a2[];
+    res2[] = b2[] - lambda21[]*a1[] - lambda22[]*a2[];
+    foreach_dimension() {
+      res1[] += (alpha11.x[0]*face_gradient_x (a1, 0) -
+		 alpha11.x[1]*face_gradient_x (a1, 1) +
+		 alpha12.x[0]*face_gradient_x (a2, 0) -
+		 alpha12.x[1]*face_gradient_x (a2, 1))/Delta;
+      res2[] += (alpha21.x[0]*face_gradient_x (a1, 0) -
+		 alpha21.x[1]*face_gradient_x (a1, 1) +
+		 alpha22.x[0]*face_gradient_x (a2, 0) -
+		 alpha22.x[1]*face_gradient_x (a2, 1))/Delta;
+    }
+    if (fabs (res1[]) > maxres)
+      maxres = fabs (res1[]);
+    if (fabs (res2[]) > maxres)
+      maxres = fabs (res2[]);
+  }
+#endif
+  return maxres;
+}
+
+#if SINGLE_PRECISION
+static double coupled_floor (scalar a1, scalar a2, scalar b1, scalar b2,
+			     struct Coupled * p)
+{
+  (const) face vector alpha11 = p->alpha11, alpha12 = p->alpha12;
+  (const) face vector alpha21 = p->alpha21, alpha22 = p->alpha22;
+  (const) scalar lambda11 = p->lambda11, lambda12 = p->lambda12;
+  (const) scalar lambda21 = p->lambda21, lambda22 = p->lambda22;
+  double rmax = 0.;
+  foreach (reduction(max:rmax)) {
+    double d11 = 0., d12 = 0., d21 = 0., d22 = 0.;
+    foreach_dimension() {
+      d11 += fabs (alpha11.x[]) + fabs (alpha11.x[1]);
+      d12 += fabs (alpha12.x[]) + fabs (alpha12.x[1]);
+      d21 += fabs (alpha21.x[]) + fabs (alpha21.x[1]);
+      d22 += fabs (alpha22.x[]) + fabs (alpha22.x[1]);
+    }
+    double r1 = fabs (b1[]) + (fabs (lambda11[]) + d11/sq(Delta))*fabs (a1[])
+      + (fabs (lambda12[]) + d12/sq(Delta))*fabs (a2[]);
+    double r2 = fabs (b2[]) + (fabs (lambda21[]) + d21/sq(Delta))*fabs (a1[])
+      + (fabs (lambda22[]) + d22/sq(Delta))*fabs (a2[]);
+    if (max (r1, r2) > rmax)
+      rmax = max (r1, r2);
+  }
+  return 4.*FLT_EPSILON*rmax;
+}
+#endif
+
+/**
+## User interface
+
+The diagonal diffusion coefficients default to one, the cross-diffusion
+coefficients and all the $\lambda_{ij}$ to zero. The convergence
+statistics are those of the coupled system as a whole. */
+
+mgstats coupled (scalar a1, scalar a2, scalar b1, scalar b2,
+		 (const) face vector alpha11 = {{-1}},
+		 (const) face vector alpha12 = {{-1}},
+		 (const) face vector alpha21 = {{-1}},
+		 (const) face vector alpha22 = {{-1}},
+		 (const) scalar lambda11 = {-1},
+		 (const) scalar lambda12 = {-1},
+		 (const) scalar lambda21 = {-1},
+		 (const) scalar lambda22 = {-1},
+		 double tolerance = 0.,
+		 int nrelax = 4,
+		 int minlevel = 0,
+		 scalar * res = NULL)
+{
+  if (alpha11.x.i < 0) alpha11 = unityf;
+  if (alpha12.x.i < 0) alpha12 = zerof;
+  if (alpha21.x.i < 0) alpha21 = zerof;
+  if (alpha22.x.i < 0) alpha22 = unityf;
+  if (lambda11.i < 0) lambda11 = zeroc;
+  if (lambda12.i < 0) lambda12 = zeroc;
+  if (lambda21.i < 0) lambda21 = zeroc;
+  if (lambda22.i < 0) lambda22 = zeroc;
+
+  /**
+  We need the coefficients on all levels of the multigrid hierarchy. */
+
+  restriction ({alpha11, alpha12, alpha21, alpha22,
+	lambda11, lambda12, lambda21, lambda22});
+
+  struct Coupled p = {
+    alpha11, alpha12, alpha21, alpha22,
+    lambda11, lambda12, lambda21, lambda22
+  };
+#if SINGLE_PRECISION
+  tolerance = max (tolerance ? tolerance : TOLERANCE,
+		   coupled_floor (a1, a2, b1, b2, &p));
+#endif
+  double defaultol = TOLERANCE;
+  if (tolerance)
+    TOLERANCE = tolerance;
+  mgstats s = mg_solve ({a1, a2}, {b1, b2}, coupled_residual, coupled_relax,
+			&p, nrelax, res, max(1, minlevel));
+  if (tolerance)
+    TOLERANCE = defaultol;
+  return s;
+}
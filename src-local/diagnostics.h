@@ -0,0 +1,100 @@
+/**
+# In-loop diagnostics
+
+Every `diagnostics_every` iterations, the integral (mass), minimum,
+maximum and $L^2$ norm of each field of a case, and optionally an
+energy functional, are appended to `diagnostics.csv`, one row per
+check:
+
+~~~
+t,i,rho_mass,rho_min,rho_max,rho_l2,c_mass,...,energy
+~~~
+
+The first row of each run is preceded by a comment line (starting
+with `#`) listing the parameters of the run.
+
+These quantities are reductions over the grid. Rather than adding a
+pass over the fields, a case computes them within a sweep which it
+does anyway, with the OpenMP/MPI reductions of `foreach()`:
+
+~~~literatec
+double mass = 0., fmin = HUGE, fmax = - HUGE, f2 = 0.;
+foreach (reduction(+:mass) reduction(min:fmin) reduction(max:fmax)
+	 reduction(+:f2)) {
+  ...
+  mass += dv()*f[];
+  ...
+}
+if (diagnostics_due())
+  diagnostics_write ((FieldStats[]){{"f", mass, fmin, fmax, f2}}, 1,
+		     params);
+~~~
+
+where `f2` is the integral of $f^2$. */
+
+#include "parameters.h"
+
+int diagnostics_every = 10;
+
+typedef struct {
+  const char * name;
+  double mass, min, max, sq;
+} FieldStats;
+
+static bool diagnostics_started = false;
+
+event diagnostics_reset (i = 0)
+{
+  diagnostics_started = false;
+}
+
+/**
+### diagnostics_due()
+
+Whether the diagnostics are written at this iteration. */
+
+bool diagnostics_due (void)
+{
+  return diagnostics_every > 0 && i % diagnostics_every == 0;
+}
+
+/**
+### diagnostics_write()
+
+Appends the statistics of the `n` fields `s` and, if given, the value
+of the `energy` functional. */
+
+void diagnostics_write (FieldStats * s, int n, Parameter * params,
+			double energy = nodata)
+{
+  if (pid() > 0)
+    return;
+  static FILE * fp = NULL;
+  if (!fp) {
+    fp = fopen ("diagnostics.csv", "a");
+    if (!fp) {
+      perror ("diagnostics.csv");
+      exit (1);
+    }
+    if (ftell (fp) == 0) {
+      fputs ("t,i", fp);
+      for (int k = 0; k < n; k++)
+	fprintf (fp, ",%s_mass,%s_min,%s_max,%s_l2",
+		 s[k].name, s[k].name, s[k].name, s[k].name);
+      fputs (energy != nodata ? ",energy\n" : "\n", fp);
+    }
+  }
+  if (!diagnostics_started) {
+    fputs ("# ", fp);
+    print_parameters (fp, params);
+    diagnostics_started = true;
+  }
+  fprintf (fp, "%g,%d", t, i);
+  for (int k = 0; k < n; k++)
+    fprintf (fp, ",%.10g,%g,%g,%g", s[k].mass, s[k].min, s[k].max,
+	     sqrt (s[k].sq));
+  if (energy != nodata)
+    fprintf (fp, ",%.10g", energy);
+  fputc ('\n', fp);
+  fflush (fp);
+}
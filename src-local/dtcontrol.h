@@ -0,0 +1,125 @@
+/**
+# Adaptive timestep control by step doubling
+
+The timestep of the cases is otherwise the maximum `DT` (or the CFL
+limit of the chemotactic flux), whatever the rate at which the
+solution evolves. Here, each step of size $h$ is also taken as two
+half steps from the same state, and the difference between the two
+results estimates the local error. For a scheme of order $p$ it scales
+as $h^{p+1}$, so that the next step is
+$$
+h_\text{new} = 0.9\,h\,(1/e)^{1/(p+1)}
+$$
+with $e$ the error relative to the tolerance `dtcontrol_tol`, limited
+to between a fifth and five times $h$ (and by the stability limit given
+by the case). When $e > 1$, the step is rejected and taken again from
+the saved state with a smaller $h$. The error of a field is its
+maximum difference relative to its maximum magnitude.
+
+The more accurate two-half-step solution is the one kept. Each step
+thus costs three steps of the underlying scheme.
+
+Rejected steps are logged on standard error, and the number of
+accepted and rejected steps is printed at the end of each run.
+
+A case provides the function advancing its fields in place by a given
+timestep, and two lists of workspace fields with the same number of
+fields as `list`:
+
+~~~literatec
+scalar C1save[], C2save[], C1full[], C2full[];
+
+event integration (i++)
+{
+  dt = dtcontrol_step ({C1, C2}, {C1save, C2save}, {C1full, C2full},
+		       DT, advance);
+}
+~~~
+*/
+
+double dtcontrol_tol = 1e-3;
+int dtcontrol_order = 1;
+
+static double dtcontrol_next = 0.;
+static int dtcontrol_accepted = 0, dtcontrol_rejected = 0;
+
+static double dtcontrol_error (scalar * list, scalar * full)
+{
+  double err = 0.;
+  for (scalar s, f in list, full) {
+    double e = 0., m = 0.;
+    foreach (reduction(max:e) reduction(max:m)) {
+      double d = fabs (s[] - f[]);
+      if (d > e)
+	e = d;
+      if (fabs (s[]) > m)
+	m = fabs (s[]);
+    }
+    if (m > 0.)
+      err = max (err, e/m);
+  }
+  return err/dtcontrol_tol;
+}
+
+/**
+### dtcontrol_step()
+
+Advances the fields of `list` by one controlled step, using `save`
+and `full` as workspace, and returns the timestep taken (already
+adjusted with `dtnext()`). The step is at most `dtmax`. */
+
+double dtcontrol_step (scalar * list, scalar * save, scalar * full,
+		       double dtmax, void (* advance) (double dt))
+{
+  double h = dtcontrol_next > 0. ? min (dtcontrol_next, dtmax) : dtmax;
+  h = dtnext (h);
+  foreach()
+    for (scalar s, v in list, save)
+      v[] = s[];
+
+  double err;
+  while (true) {
+    advance (h);
+    foreach()
+      for (scalar s, v, f in list, save, full)
+	f[] = s[], s[] = v[];
+    advance (h/2.);
+    advance (h/2.);
+    err = dtcontrol_error (list, full);
+    if (err <= 1. || h <= 1e-6*dtmax)
+      break;
+
+    double h1 = h*max (0.2, 0.9*pow (err, -1./(dtcontrol_order + 1)));
+    if (pid() == 0)
+      fprintf (stderr, "dtcontrol: i = %d t = %g rejected dt = %g "
+	       "(error %g), retrying with dt = %g\n", i, t, h, err, h1);
+    dtcontrol_rejected++;
+    foreach()
+      for (scalar s, v in list, save)
+	s[] = v[];
+    h = dtnext (h1);
+  }
+
+  dtcontrol_accepted++;
+  dtcontrol_next = h*min (5., 0.9*pow (max (err, 1e-10),
+					-1./(dtcontrol_order + 1)));
+  return h;
+}
+
+/**
+The controller starts every run afresh, with the maximum timestep as
+first guess. */
+
+event dtcontrol_reset (i = 0)
+{
+  dtcontrol_next = 0.;
+  dtcontrol_accepted = dtcontrol_rejected = 0;
+}
+
+event dtcontrol_summary (t = end)
+{
+  if (pid() == 0)
+    fprintf (stderr, "dtcontrol: %d steps accepted, %d rejected "
+	     "(tolerance %g)\n", dtcontrol_accepted, dtcontrol_rejected,
+	     dtcontrol_tol);
+}
@@ -0,0 +1,183 @@
+/**
+# Poisson--Helmholtz solves in single and mixed precision
+
+The implicit steps of the cases solve
+$$
+\nabla\cdot(\alpha\nabla a) + \lambda a = b
+$$
+with the multigrid solver of [poisson.h](/src/poisson.h).
+`helmholtz()` has the interface of `poisson()` and, in the default
+double precision build, just calls it. It adapts the solves to the
+precision of the fields.
+
+## Single and mixed precision
+
+With `-DSINGLE_PRECISION=1`, Basilisk stores all the fields as `float`,
+which halves the memory traffic of every sweep. The smallest residual
+which can then be reached is set by the rounding of the solution:
+relative errors of $10^{-7}$ in $a$ give residuals of order
+$10^{-7}(2d\,\alpha/\Delta^2 + |\lambda|)|a|$, above the default
+tolerance on fine grids, where the solver would spend all its
+iterations (and print a warning) at every step without converging.
+The tolerance of each solve is thus raised to this rounding floor,
+computed from the current fields (see `helmholtz_floor()`): the solves
+stop when the solution is as accurate as a `float` allows.
+
+Compiling with `-DMIXED_PRECISION=1` as well solves the problems by
+iterative refinement: within a solve, the solution is held as the sum
+of its `float` value and of a `float` correction `lo` of its rounding
+error, the residual is computed in double precision from this sum, and
+the correction equation is solved by the `float` multigrid of
+`poisson()`, to a tenth of the current residual, before being added to
+the solution. The tolerance is that of the double precision solver, but
+it applies to the sum: the solution returned is the `float` rounding of
+the converged sum, and `lo` is discarded, so that the residual of the
+stored solution is again at the rounding floor. What mixed precision
+buys is a solution which is the correctly rounded value of the
+converged one, rather than the last iterate of a stalled single
+precision solve. It buys no accuracy in the state carried from one
+step to the next, which is the `float` fields in both modes: carrying
+`lo` across steps would amount to storing the solution in double
+precision, i.e. to the double precision build.
+
+The double precision residual uses the discretisation of a uniform
+grid: it is an error to compile mixed precision on trees. */
+
+#include <float.h>
+#include "poisson.h"
+
+#if MIXED_PRECISION && !SINGLE_PRECISION
+# error "MIXED_PRECISION requires SINGLE_PRECISION"
+#endif
+#if MIXED_PRECISION && TREE
+# error "MIXED_PRECISION requires a uniform grid"
+#endif
+
+#if MIXED_PRECISION
+/**
+The work fields of the refinement (`lo`, the residual and the
+correction) are allocated by the first solve and kept until the end of
+the run, rather than at every solve. */
+
+static scalar * helmholtz_work = NULL;
+
+static mgstats helmholtz_refine (scalar a, scalar b,
+				 (const) face vector alpha,
+				 (const) scalar lambda,
+				 double tolerance, int nrelax, int minlevel,
+				 scalar * res)
+{
+  /**
+  The same fields serve all the solved fields: at each solve, the
+  rounding error `lo` takes the boundary conditions of `a`, the
+  correction `da` their homogeneous version (as in `mg_solve()`). */
+
+  if (!helmholtz_work)
+    helmholtz_work = list_clone ({a, a, a});
+  scalar lo = helmholtz_work[0], r = helmholtz_work[1];
+  scalar da = helmholtz_work[2];
+  for (int d = 0; d < nboundary; d++) {
+    lo.boundary[d] = a.boundary[d];
+    lo.boundary_homogeneous[d] = da.boundary_homogeneous[d] =
+      da.boundary[d] = a.boundary_homogeneous[d];
+  }
+  foreach()
+    lo[] = 0.;
+
+  mgstats s = {0};
+  for (int n = 0; n < NITERMAX; n++) {
+    double maxres = 0.;
+    foreach (reduction(max:maxres)) {
+      double x = (double) a[] + lo[];
+      r[] = b[] - lambda[]*x;
+      foreach_dimension()
+	r[] -= (alpha.x[1]*((double) a[1] + lo[1] - x) -
+		alpha.x[]*(x - (double) a[-1] - lo[-1]))/sq(Delta);
+      if (fabs (r[]) > maxres)
+	maxres = fabs (r[]);
+    }
+    if (n == 0)
+      s.resb = maxres;
+    s.resa = maxres;
+    if (n > 0 && maxres < tolerance)
+      break;
+
+    foreach()
+      da[] = 0.;
+    mgstats c = poisson (da, r, alpha, lambda,
+			 max (0.1*maxres, 0.5*tolerance),
+			 nrelax, minlevel, res);
+    s.i += c.i, s.nrelax = c.nrelax, s.minlevel = c.minlevel;
+    foreach() {
+      double x = (double) a[] + lo[] + da[];
+      a[] = x;
+      lo[] = x - (double) a[];
+    }
+  }
+  if (s.resa > tolerance)
+    fprintf (stderr,
+	     "WARNING: convergence for %s not reached after %d iterations\n"
+	     "  res: %g\n", a.name, s.i, s.resa);
+  return s;
+}
+
+event helmholtz_cleanup (t = end)
+{
+  if (helmholtz_work) {
+    delete (helmholtz_work);
+    free (helmholtz_work);
+    helmholtz_work = NULL;
+  }
+}
+#endif
+
+#if SINGLE_PRECISION && !MIXED_PRECISION
+/**
+The rounding floor of the residual: the largest rounding error of the
+terms of the residual in a cell, for relative errors of a few `float`
+epsilons in each field. */
+
+static double helmholtz_floor (scalar a, scalar b, (const) face vector alpha,
+			       (const) scalar lambda)
+{
+  double rmax = 0.;
+  foreach (reduction(max:rmax)) {
+    double d = 0.;
+    foreach_dimension()
+      d += fabs (alpha.x[]) + fabs (alpha.x[1]);
+    double r = fabs (b[]) + (fabs (lambda[]) + d/sq(Delta))*fabs (a[]);
+    if (r > rmax)
+      rmax = r;
+  }
+  return 4.*FLT_EPSILON*rmax;
+}
+#endif
+
+/**
+## User interface
+
+The arguments and defaults are those of `poisson()`. */
+
+mgstats helmholtz (scalar a, scalar b,
+		   (const) face vector alpha = {{-1}},
+		   (const) scalar lambda = {-1},
+		   double tolerance = 0.,
+		   int nrelax = 4,
+		   int minlevel = 0,
+		   scalar * res = NULL)
+{
+  if (alpha.x.i < 0) alpha = unityf;
+  if (lambda.i < 0) lambda = zeroc;
+
+#if MIXED_PRECISION
+  return helmholtz_refine (a, b, alpha, lambda,
+			   tolerance ? tolerance : TOLERANCE,
+			   nrelax, minlevel, res);
+#else
+#if SINGLE_PRECISION
+  tolerance = max (tolerance ? tolerance : TOLERANCE,
+		   helmholtz_floor (a, b, alpha, lambda));
+#endif
+  return poisson (a, b, alpha, lambda, tolerance, nrelax, minlevel, res);
+#endif
+}
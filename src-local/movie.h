@@ -0,0 +1,220 @@
+/**
+# Asynchronous movies
+
+With `output_ppm()`, each frame of a movie is interpolated onto the
+image, colour-mapped and piped to the encoder by the time-stepping
+loop, which stalls meanwhile. Here, the time loop only *captures* the
+field: its values are sampled on a uniform grid close to the image
+resolution (see [snapshot_sample()](snapshot.h)) and copied into a ring
+buffer. A background writer thread does the interpolation, the colour
+mapping and the encoding, so that the movie no longer adds to the
+critical path of a timestep.
+
+The writer thread is started with the first frame and joined when the
+program exits, once all the queued frames have been encoded. When the
+buffer is full, the capture waits for the writer rather than dropping
+frames. With MPI, the samples are gathered on the root process, which
+owns the writer thread.
+
+Movies with an `.mp4` extension are piped to Basilisk's `ppm2mp4`, as
+with `output_ppm()`; any other file receives the raw stream of PPM
+images. As with `output_ppm()`, the frames of successive runs of the
+same executable go to the same movie. */
+
+#pragma autolink -lpthread
+#include <pthread.h>
+#include "snapshot.h"
+
+#define MOVIE_FRAMES 8
+#define MOVIE_FILES 4
+
+typedef struct {
+  char file[80];
+  int n, m;
+  double spread;
+  double * data;
+} MovieFrame;
+
+static struct {
+  char file[80];
+  FILE * fp;
+  bool pipe;
+} movie_files[MOVIE_FILES];
+
+static struct {
+  MovieFrame frame[MOVIE_FRAMES];
+  int head, count;
+  bool started, done;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+} movie = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .changed = PTHREAD_COND_INITIALIZER
+};
+
+/**
+## Writer thread
+
+The colour scale spans the range of the field or, when `spread` is
+positive, the average plus or minus `spread` standard deviations (as
+for `output_ppm()`). The image is the bilinear interpolation of the
+samples (the `linear = true` option of `output_ppm()`), with the
+"jet" colour map. */
+
+static void movie_jet (double v, unsigned char * c)
+{
+  v = clamp (v, 0., 1.);
+  c[0] = 255*clamp (1.5 - fabs (4.*v - 3.), 0., 1.);
+  c[1] = 255*clamp (1.5 - fabs (4.*v - 2.), 0., 1.);
+  c[2] = 255*clamp (1.5 - fabs (4.*v - 1.), 0., 1.);
+}
+
+static void movie_render (MovieFrame * f, unsigned char * image)
+{
+  int m = f->m, n = f->n;
+  double vmin = HUGE, vmax = - HUGE, sum = 0., sum2 = 0.;
+  for (int k = 0; k < m*m; k++) {
+    double v = f->data[k];
+    if (v < vmin) vmin = v;
+    if (v > vmax) vmax = v;
+    sum += v, sum2 += sq(v);
+  }
+  if (f->spread > 0.) {
+    double avg = sum/(m*m);
+    double sd = sqrt (max (sum2/(m*m) - sq(avg), 0.));
+    vmin = avg - f->spread*sd, vmax = avg + f->spread*sd;
+  }
+  double range = vmax > vmin ? vmax - vmin : 1.;
+
+  /**
+  The first row of the image is the top of the domain. */
+
+  for (int j = 0; j < n; j++) {
+    double y = clamp ((n - j - 0.5)*m/(double) n - 0.5, 0., m - 1.);
+    int j0 = max (min ((int) y, m - 2), 0), j1 = min (j0 + 1, m - 1);
+    double wy = y - j0;
+    for (int i = 0; i < n; i++) {
+      double x = clamp ((i + 0.5)*m/(double) n - 0.5, 0., m - 1.);
+      int i0 = max (min ((int) x, m - 2), 0), i1 = min (i0 + 1, m - 1);
+      double wx = x - i0;
+      double * d = f->data;
+      double v = ((1. - wy)*((1. - wx)*d[j0*m + i0] + wx*d[j0*m + i1]) +
+		  wy*((1. - wx)*d[j1*m + i0] + wx*d[j1*m + i1]));
+      movie_jet ((v - vmin)/range, image + 3*(j*n + i));
+    }
+  }
+}
+
+static FILE * movie_open (const char * file)
+{
+  int k;
+  for (k = 0; k < MOVIE_FILES && movie_files[k].fp; k++)
+    if (!strcmp (movie_files[k].file, file))
+      return movie_files[k].fp;
+  if (k == MOVIE_FILES) {
+    fprintf (stderr, "movie: too many movies\n");
+    exit (1);
+  }
+  const char * ext = strrchr (file, '.');
+  movie_files[k].pipe = ext && !strcmp (ext, ".mp4");
+  if (movie_files[k].pipe) {
+    char command[100];
+    snprintf (command, sizeof (command), "ppm2mp4 %s", file);
+    movie_files[k].fp = popen (command, "w");
+  }
+  else
+    movie_files[k].fp = fopen (file, "w");
+  if (!movie_files[k].fp) {
+    perror (file);
+    exit (1);
+  }
+  snprintf (movie_files[k].file, sizeof (movie_files[k].file), "%s", file);
+  return movie_files[k].fp;
+}
+
+static void * movie_writer (void * arg)
+{
+  unsigned char * image = NULL;
+  int size = 0;
+  pthread_mutex_lock (&movie.lock);
+  while (true) {
+    while (!movie.count && !movie.done)
+      pthread_cond_wait (&movie.changed, &movie.lock);
+    if (!movie.count)
+      break;
+    MovieFrame * f = &movie.frame[movie.head];
+    pthread_mutex_unlock (&movie.lock);
+
+    if (3*f->n*f->n > size)
+      image = realloc (image, (size = 3*f->n*f->n));
+    movie_render (f, image);
+    FILE * fp = movie_open (f->file);
+    fprintf (fp, "P6\n%d %d\n255\n", f->n, f->n);
+    fwrite (image, 1, 3*f->n*f->n, fp);
+    free (f->data);
+
+    pthread_mutex_lock (&movie.lock);
+    movie.head = (movie.head + 1) % MOVIE_FRAMES;
+    movie.count--;
+    pthread_cond_broadcast (&movie.changed);
+  }
+  pthread_mutex_unlock (&movie.lock);
+  free (image);
+  return NULL;
+}
+
+/**
+At exit, the writer thread encodes the remaining frames and the movies
+are closed (which completes the encoding of `.mp4` files). */
+
+static void movie_close (void)
+{
+  pthread_mutex_lock (&movie.lock);
+  movie.done = true;
+  pthread_cond_broadcast (&movie.changed);
+  pthread_mutex_unlock (&movie.lock);
+  pthread_join (movie.thread, NULL);
+  for (int k = 0; k < MOVIE_FILES && movie_files[k].fp; k++)
+    if (movie_files[k].pipe)
+      pclose (movie_files[k].fp);
+    else
+      fclose (movie_files[k].fp);
+}
+
+/**
+## User interface
+
+### movie_frame()
+
+Captures field `f` as the next frame of movie `file`, an image of
+`n`$\times$`n` pixels. */
+
+void movie_frame (scalar f, const char * file, int n = 200,
+		  double spread = 0.)
+{
+  int level = min (depth(), (int) ceil (log2 (n)));
+  int m = 1 << level;
+  double * data = malloc (sizeof (double)*m*m);
+  snapshot_sample ({f}, level, data);
+  if (pid() > 0) {
+    free (data);
+    return;
+  }
+
+  pthread_mutex_lock (&movie.lock);
+  if (!movie.started) {
+    pthread_create (&movie.thread, NULL, movie_writer, NULL);
+    atexit (movie_close);
+    movie.started = true;
+  }
+  while (movie.count == MOVIE_FRAMES)
+    pthread_cond_wait (&movie.changed, &movie.lock);
+  MovieFrame * frame = &movie.frame[(movie.head + movie.count) % MOVIE_FRAMES];
+  snprintf (frame->file, sizeof (frame->file), "%s", file);
+  frame->n = n, frame->m = m, frame->spread = spread;
+  frame->data = data;
+  movie.count++;
+  pthread_cond_broadcast (&movie.changed);
+  pthread_mutex_unlock (&movie.lock);
+}
@@ -0,0 +1,147 @@
+/**
+# Command-line parameters
+
+Cases read their model parameters as `name=value` pairs from the
+command line, for example
+
+~~~bash
+./brusselator mu=0.1 D=8
+~~~
+
+so that a single executable can be launched once per point of a
+parameter sweep (see [runSweep.sh](../simulationCases/runSweep.sh)).
+
+Each case lists the parameters it accepts in a table of `Parameter`
+entries terminated by `{NULL}`:
+
+~~~literatec
+Parameter params[] = {
+  {"mu", &mu},
+  {"D", &D},
+  {NULL}
+};
+if (read_parameters (argc, argv, params))
+  run();
+~~~
+
+Integer parameters, such as refinement levels, are given by a pointer
+in the third field instead, e.g. `{"maxlevel", NULL, &maxlevel}`.
+
+## Baked parameters
+
+For production runs at a fixed point, a parameter can instead be
+compiled in as a constant, so that the compiler folds it (and the
+coefficients computed from it) into the loops of the solvers. A case
+declares each such parameter as
+
+~~~literatec
+#ifdef BAKED_mu
+static const double mu = BAKED_mu;
+#else
+double mu;
+#endif
+~~~
+
+and gives its entry the address of the constant as `baked` instead:
+
+~~~literatec
+Parameter params[] = {
+#ifdef BAKED_mu
+  {"mu", .baked = &mu},
+#else
+  {"mu", &mu},
+#endif
+  ...
+~~~
+
+A baked entry is read-only: it is written by `print_parameters()`
+like any other, so that all the outputs still record its value, but
+`read_parameters()` rejects any other value for it. In particular, a
+[checkpoint](checkpoint.h) written by a build with another value is
+refused, while one written by an unbaked build with the same value can
+be resumed. The value is given with `-DBAKED_mu=0.1`, or with the
+`-B mu=0.1` option of [runCases.sh](../simulationCases/runCases.sh). */
+
+typedef struct {
+  const char * name;
+  double * value;
+  int * ivalue;
+  const double * baked;
+} Parameter;
+
+/**
+### print_parameters()
+
+Writes the current value of every parameter of the table as
+`name=value` pairs on a single line, with `format` for the real
+values. With `json`, writes instead the members `"name": value` of a
+JSON object, without braces or newline. This is how all the outputs
+record the parameters of a run. */
+
+void print_parameters (FILE * fp, Parameter * table,
+		       const char * format = "%g", bool json = false)
+{
+  for (Parameter * p = table; p->name; p++) {
+    fprintf (fp, json ? "%s\"%s\": " : "%s%s=",
+	     p == table ? "" : json ? ", " : " ", p->name);
+    if (p->ivalue)
+      fprintf (fp, "%d", *p->ivalue);
+    else
+      fprintf (fp, format, p->baked ? *p->baked : *p->value);
+  }
+  if (!json)
+    fputc ('\n', fp);
+}
+
+/**
+### read_parameters()
+
+Parses the command-line arguments against the table and returns the
+number of parameters which were set. Unknown names or malformed values
+are fatal, since a silently ignored typo would waste a whole sweep, as
+is a value of a baked parameter which differs from the compiled-in
+one. */
+
+int read_parameters (int argc, char * argv[], Parameter * table)
+{
+  int n = 0;
+  for (int a = 1; a < argc; a++) {
+    char * eq = strchr (argv[a], '='), * end = NULL;
+    Parameter * p = table;
+    if (eq)
+      for (; p->name; p++)
+	if (strlen (p->name) == eq - argv[a] &&
+	    !strncmp (p->name, argv[a], eq - argv[a]))
+	  break;
+    if (eq && p->name && p->ivalue) {
+      long value = strtol (eq + 1, &end, 10);
+      if (end != eq + 1 && *end == '\0') {
+	*p->ivalue = value;
+	n++;
+	continue;
+      }
+    }
+    else if (eq && p->name) {
+      double value = strtod (eq + 1, &end);
+      if (end != eq + 1 && *end == '\0' && p->baked && value != *p->baked) {
+	if (pid() == 0)
+	  fprintf (stderr, "%s: '%s' differs from the compiled-in %s=%.17g\n",
+		   argv[0], argv[a], p->name, *p->baked);
+	exit (1);
+      }
+      if (end != eq + 1 && *end == '\0') {
+	if (!p->baked)
+	  *p->value = value;
+	n++;
+	continue;
+      }
+    }
+    if (pid() == 0) {
+      fprintf (stderr, "%s: unknown or malformed parameter '%s'\n"
+	       "accepted parameters: ", argv[0], argv[a]);
+      print_parameters (stderr, table);
+    }
+    exit (1);
+  }
+  return n;
+}
@@ -0,0 +1,182 @@
+/**
+# Profiling of the cases
+
+A light-weight profiling surface, to find out whether the outputs or
+the implicit solves dominate the cost of a run and to track
+performance across commits. It records
+
+* the wall-clock time spent in each instrumented event,
+* for each timestep, the number of leaf cells, the wall-clock time and
+  the statistics of the two multigrid solves (cycles, relaxations,
+  maximum residual before and after the solve),
+
+and writes them to two files in the working directory:
+
+* `profile.csv`: one row per timestep,
+* `profile.json`: one summary object per run (one line per run,
+  i.e. [JSON Lines](https://jsonlines.org)).
+
+Each run of the executable (e.g. the successive runs of the default
+parameter sequence of a case) has its own `run` index. The timings are
+those of the root process.
+
+An event is instrumented with
+
+~~~literatec
+event movie (i = 1; i += 10)
+{
+  timer tm = timer_start();
+  ...
+  profile_event ("movie", tm);
+}
+~~~
+
+and the integration event ends with a call to `profile_step()`. */
+
+#include <sys/resource.h>
+#include "parameters.h"
+
+#define PROFILE_EVENTS 16
+
+static struct {
+  const char * name;
+  int calls;
+  double wall;
+} profile_events[PROFILE_EVENTS];
+
+static struct {
+  int run, steps;
+  long mg1, mg2;
+  int mg1max, mg2max;
+  double cells;
+  timer start;
+} profile_stats = {-1};
+
+/**
+### profile_event()
+
+Adds the wall-clock time elapsed since `tm` to the time spent in event
+`name`. */
+
+void profile_event (const char * name, timer tm)
+{
+  double wall = timer_elapsed (tm);
+  for (int n = 0; n < PROFILE_EVENTS; n++)
+    if (!profile_events[n].name || !strcmp (profile_events[n].name, name)) {
+      profile_events[n].name = name;
+      profile_events[n].calls++;
+      profile_events[n].wall += wall;
+      return;
+    }
+}
+
+/**
+### profile_step()
+
+Records the timestep just taken: the integration event started at
+`tm`, with timestep `dt` and the statistics `s1` and `s2` of the
+solves of the two species (which are the same for a coupled solve). */
+
+void profile_step (timer tm, double dt, mgstats s1, mgstats s2)
+{
+  double wall = timer_elapsed (tm);
+  profile_event ("integration", tm);
+  profile_stats.steps++;
+  profile_stats.cells += grid->tn;
+  profile_stats.mg1 += s1.i, profile_stats.mg2 += s2.i;
+  profile_stats.mg1max = max (profile_stats.mg1max, s1.i);
+  profile_stats.mg2max = max (profile_stats.mg2max, s2.i);
+
+  if (pid() == 0) {
+    static FILE * fp = NULL;
+    if (!fp) {
+      fp = fopen ("profile.csv", "a");
+      if (!fp) {
+	perror ("profile.csv");
+	exit (1);
+      }
+      if (ftell (fp) == 0)
+	fputs ("run,i,t,dt,cells,wall,cells_per_s,"
+	       "mg1_cycles,mg1_nrelax,mg1_resb,mg1_resa,"
+	       "mg2_cycles,mg2_nrelax,mg2_resb,mg2_resa\n", fp);
+    }
+    fprintf (fp, "%d,%d,%g,%g,%ld,%g,%g,%d,%d,%g,%g,%d,%d,%g,%g\n",
+	     profile_stats.run, i, t, dt, (long) grid->tn, wall,
+	     wall > 0. ? grid->tn/wall : 0.,
+	     s1.i, s1.nrelax, s1.resb, s1.resa,
+	     s2.i, s2.nrelax, s2.resb, s2.resa);
+    fflush (fp);
+  }
+}
+
+/**
+At the start of each run, the counters are reset. This event is
+defined before those of the case, so that the `init` event of the case
+is also timed. */
+
+event profile_reset (i = 0)
+{
+  int run = profile_stats.run + 1;
+  memset (&profile_stats, 0, sizeof (profile_stats));
+  memset (profile_events, 0, sizeof (profile_events));
+  profile_stats.run = run;
+  profile_stats.start = timer_start();
+}
+
+/**
+### profile_summary()
+
+Appends the summary of the run, with its parameters, to
+`profile.json`. The throughput is given both for the whole run
+(`cells_per_s`) and for the integration alone (`solver_cells_per_s`),
+in leaf cells times timesteps per second. The peak resident set size is
+the maximum over all processes. */
+
+void profile_summary (Parameter * params)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  long rss = usage.ru_maxrss/1024; // bytes on macOS
+#else
+  long rss = usage.ru_maxrss;      // kilobytes on Linux
+#endif
+#if _MPI
+  MPI_Allreduce (MPI_IN_PLACE, &rss, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  if (pid() > 0)
+    return;
+
+  FILE * fp = fopen ("profile.json", "a");
+  if (!fp) {
+    perror ("profile.json");
+    exit (1);
+  }
+  double wall = timer_elapsed (profile_stats.start), solver = 0.;
+  int steps = max (profile_stats.steps, 1);
+  fprintf (fp, "{\"run\": %d, \"parameters\": {", profile_stats.run);
+  print_parameters (fp, params, json = true);
+  fprintf (fp, "}, \"steps\": %d, \"t\": %g, \"wall\": %g, \"events\": {",
+	   profile_stats.steps, t, wall);
+  for (int n = 0; n < PROFILE_EVENTS && profile_events[n].name; n++) {
+    fprintf (fp, "%s\"%s\": {\"calls\": %d, \"wall\": %g}", n ? ", " : "",
+	     profile_events[n].name, profile_events[n].calls,
+	     profile_events[n].wall);
+    if (!strcmp (profile_events[n].name, "integration"))
+      solver = profile_events[n].wall;
+  }
+  fprintf (fp, "}, \"cells_steps\": %g, \"cells_per_s\": %g, "
+	   "\"solver_cells_per_s\": %g, ",
+	   profile_stats.cells, wall > 0. ? profile_stats.cells/wall : 0.,
+	   solver > 0. ? profile_stats.cells/solver : 0.);
+  fprintf (fp, "\"mg1\": {\"cycles\": %ld, \"cycles_per_step\": %g, "
+	   "\"max_cycles\": %d}, ",
+	   profile_stats.mg1, profile_stats.mg1/(double) steps,
+	   profile_stats.mg1max);
+  fprintf (fp, "\"mg2\": {\"cycles\": %ld, \"cycles_per_step\": %g, "
+	   "\"max_cycles\": %d}, ",
+	   profile_stats.mg2, profile_stats.mg2/(double) steps,
+	   profile_stats.mg2max);
+  fprintf (fp, "\"peak_rss_kb\": %ld}\n", rss);
+  fclose (fp);
+}
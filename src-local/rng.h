@@ -0,0 +1,62 @@
+/**
+# Counter-based random numbers
+
+Basilisk's `noise()` draws from the global sequence of `rand()`: the
+perturbation of a cell depends on the order in which the cells are
+visited (i.e. on the number of threads or processes) and all the runs
+of an executable see the same sequence.
+
+Here the random number of a cell is instead a hash of
+
+* the seed `rng_seed` of the run,
+* the index `rng_member` of the realisation within an ensemble,
+* a stream index, to draw independent numbers for several
+  fields,
+* the level and integer coordinates of the cell,
+
+mixed with the finaliser of
+[SplitMix64](https://doi.org/10.1145/2714064.2660195). The numbers are
+thus reproducible, independent of the parallel decomposition, and
+statistically independent between seeds, members, streams and cells,
+without any state to save (e.g. in [checkpoints](checkpoint.h)) or to
+share between threads. */
+
+#include <stdint.h>
+
+int rng_seed = 0, rng_member = 0;
+
+static inline uint64_t rng_mix (uint64_t z)
+{
+  z += 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+### rng_uniform()
+
+Returns a number uniformly distributed in $[0,1)$ for the given
+counter and stream. */
+
+double rng_uniform (uint64_t counter, int stream = 0)
+{
+  uint64_t h = rng_mix ((uint64_t) rng_seed);
+  h = rng_mix (h ^ (uint64_t) rng_member);
+  h = rng_mix (h ^ (uint64_t) stream);
+  h = rng_mix (h ^ counter);
+  return (h >> 11)/9007199254740992.;
+}
+
+/**
+### rng_noise()
+
+The counter-based equivalent of `noise()` for the current cell and the
+given stream: a number uniformly distributed in $[-1,1)$. */
+
+double rng_noise (Point point, int stream)
+{
+  uint64_t ix = (x - X0)/Delta, iy = (y - Y0)/Delta;
+  uint64_t counter = ((uint64_t) point.level << 58) | (ix << 29) | iy;
+  return 2.*rng_uniform (counter, stream) - 1.;
+}
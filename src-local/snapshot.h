@@ -0,0 +1,243 @@
+/**
+# Binary field snapshots
+
+The movie and images written with `output_ppm()` are interpolated,
+8-bit and lossy. For quantitative analysis we also append
+the raw cell values of a list of fields to a binary *snapshot stream*,
+which tools in [postProcess/](../postProcess/snapshots.py) can
+memory-map without re-running the simulation.
+
+## Format
+
+The stream is a sequence of self-describing frames, each made of a
+1024-byte header followed by the field data. All numbers are in the
+native byte order (little-endian on all the platforms we use):
+
+| offset | type        | content                                        |
+|--------|-------------|------------------------------------------------|
+| 0      | `char[8]`   | magic `SNAPSHOT`                               |
+| 8      | `int32`     | format version (3)                             |
+| 12     | `int32`     | sampling level (leaf cells: depth of the tree) |
+| 16     | `int32`     | `n` $= 2^\text{level}$ samples per direction   |
+| 20     | `int32`     | number of fields `nf`                          |
+| 24     | `int32`     | iteration `i`                                  |
+| 28     | `int32`     | number of leaf cells `nc`, or 0 (uniform)      |
+| 32     | `double[4]` | `t`, `L0`, `X0`, `Y0`                          |
+| 64     | `char[192]` | space-separated field names                    |
+| 256    | `char[768]` | run parameters as `name=value` pairs           |
+| 1024   | `double`    | `nf` $\times$ `n` $\times$ `n` values (uniform) |
+
+The values of each field are stored row by row, $y$ varying slowest.
+Frames of a stream can have different sizes (e.g. different levels),
+so that readers must walk the headers. On a multigrid sampled at its
+own level, the values are exactly the cell values. A run whose
+parameters do not fit in the header stops rather than truncate them.
+Earlier versions had a 512-byte header, with 256 bytes of parameters,
+for uniform (version 1) and leaf-cell (version 2) frames.
+
+On an adaptive tree, a uniform frame at the finest level would be
+mostly made of copies of coarse leaves, and would grow fourfold with
+every level of refinement. The frames of a tree (`nc` > 0) therefore
+hold the raw leaf cells instead:
+
+| offset | type        | content                                        |
+|--------|-------------|------------------------------------------------|
+| 1024   | `double`    | `nf` $\times$ `nc` values, field by field       |
+| ...    | `int32`     | `nc` levels of the cells                       |
+| ...    | `int32`     | `nc` indices of the cells along $x$            |
+| ...    | `int32`     | `nc` indices of the cells along $y$            |
+
+where the indices of a cell of level $l$ count cells of size
+$L_0/2^l$ from `X0` and `Y0`. A uniform frame of a tree can still be
+requested by giving a sampling level: leaves coarser than this level
+then fill all the samples they cover, and finer cells are replaced by
+their (restricted) average at the sampling level. */
+
+#include "parameters.h"
+
+typedef struct {
+  char magic[8];
+  int version, level, n, nfields, i, cells;
+  double t, L0, X0, Y0;
+  char fields[192];
+  char parameters[768];
+} SnapshotHeader;
+
+/**
+### snapshot_sample()
+
+Fills `data` with the values of the fields of `list` sampled at
+`level`, in the layout of the frames above. With MPI, the samples of
+each process are summed onto the root process: only the `data` of the
+root process is complete. */
+
+void snapshot_sample (scalar * list, int level, double * data)
+{
+  int n = 1 << level, nf = list_len (list);
+  memset (data, 0, sizeof (double)*nf*n*n);
+  restriction (list);
+  foreach_level_or_leaf (level) {
+    int m = 1 << (level - point.level);
+    int i0 = round ((x - Delta/2. - X0)*n/L0);
+    int j0 = round ((y - Delta/2. - Y0)*n/L0);
+    int f = 0;
+    for (scalar s in list) {
+      double v = s[];
+      for (int jj = j0; jj < j0 + m; jj++)
+	for (int ii = i0; ii < i0 + m; ii++)
+	  data[((size_t) f*n + jj)*n + ii] = v;
+      f++;
+    }
+  }
+
+#if _MPI
+  if (pid() == 0)
+    MPI_Reduce (MPI_IN_PLACE, data, nf*n*n, MPI_DOUBLE, MPI_SUM, 0,
+		MPI_COMM_WORLD);
+  else
+    MPI_Reduce (data, NULL, nf*n*n, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+#endif
+}
+
+#if TREE
+/**
+### snapshot_leaves()
+
+Fills `data` (allocated by the function) with the values, levels and
+indices of the leaf cells, in the layout of the tree frames above,
+after `offset` bytes for the header. Returns the number of cells. With
+MPI, the cells of all the processes are gathered on the root process,
+which is the only one to allocate `data`. */
+
+static int snapshot_leaves (scalar * list, size_t offset, char ** data)
+{
+  int nf = list_len (list), nc = 0;
+  foreach (serial)
+    nc++;
+  double * v = malloc (sizeof (double)*nf*max(nc, 1));
+  int * c = malloc (3*sizeof (int)*max(nc, 1));
+  int k = 0;
+  foreach (serial) {
+    int f = 0;
+    for (scalar s in list)
+      v[f++*nc + k] = s[];
+    c[k] = point.level;
+    c[nc + k] = round ((x - Delta/2. - X0)/Delta);
+    c[2*nc + k] = round ((y - Delta/2. - Y0)/Delta);
+    k++;
+  }
+
+  int total = nc;
+#if _MPI
+  int * counts = NULL, * displs = NULL;
+  if (pid() == 0) {
+    counts = malloc (npe()*sizeof (int));
+    displs = malloc (npe()*sizeof (int));
+  }
+  MPI_Gather (&nc, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (pid() == 0) {
+    total = 0;
+    for (int p = 0; p < npe(); p++)
+      displs[p] = total, total += counts[p];
+  }
+#endif
+
+  *data = NULL;
+  if (pid() == 0)
+    *data = calloc (1, offset + (nf*sizeof (double) + 3*sizeof (int))*total);
+  double * values = pid() == 0 ? (double *) (*data + offset) : NULL;
+  int * cells = pid() == 0 ? (int *) (values + nf*total) : NULL;
+#if _MPI
+  for (int f = 0; f < nf; f++)
+    MPI_Gatherv (v + f*nc, nc, MPI_DOUBLE, values ? values + f*total : NULL,
+		 counts, displs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  for (int d = 0; d < 3; d++)
+    MPI_Gatherv (c + d*nc, nc, MPI_INT, cells ? cells + d*total : NULL,
+		 counts, displs, MPI_INT, 0, MPI_COMM_WORLD);
+  free (counts);
+  free (displs);
+#else
+  memcpy (values, v, sizeof (double)*nf*nc);
+  memcpy (cells, c, 3*sizeof (int)*nc);
+#endif
+  free (v);
+  free (c);
+  return total;
+}
+#endif
+
+/**
+### snapshot()
+
+Appends one frame with the fields of `list` to `file`: sampled at
+`level` (default: the depth of the grid), or, on a tree without
+`level`, the leaf cells. The optional parameter table is recorded in
+the header. This only works in two dimensions.
+
+The frame is assembled in memory and appended with a single unbuffered
+`fwrite()`, i.e. a single system call: a frame is never split by the
+stdio buffer, so that a reader can safely map the stream while the
+simulation is still running (it only needs to ignore a trailing
+incomplete frame). */
+
+void snapshot (scalar * list, const char * file,
+	       int level = -1, Parameter * params = NULL)
+{
+  int nf = list_len (list), cells = 0;
+  char * frame;
+  size_t size;
+#if TREE
+  if (level < 0) {
+    level = depth();
+    cells = snapshot_leaves (list, sizeof (SnapshotHeader), &frame);
+    size = sizeof (SnapshotHeader) + (nf*sizeof (double) + 3*sizeof (int))*cells;
+  }
+  else
+#endif
+  {
+    if (level < 0)
+      level = depth();
+    int n = 1 << level;
+    size = sizeof (SnapshotHeader) + sizeof (double)*nf*n*n;
+    frame = calloc (1, size);
+    snapshot_sample (list, level, (double *) (frame + sizeof (SnapshotHeader)));
+  }
+
+  if (pid() == 0) {
+    SnapshotHeader * h = (SnapshotHeader *) frame;
+    memcpy (h->magic, "SNAPSHOT", 8);
+    h->version = 3, h->cells = cells;
+    h->level = level, h->n = 1 << level, h->nfields = nf, h->i = i;
+    h->t = t, h->L0 = L0, h->X0 = X0, h->Y0 = Y0;
+    for (scalar s in list) {
+      if (*h->fields)
+	strncat (h->fields, " ", sizeof (h->fields) - strlen (h->fields) - 1);
+      strncat (h->fields, s.name, sizeof (h->fields) - strlen (h->fields) - 1);
+    }
+    if (params) {
+      char line[4096] = "";
+      FILE * fp = fmemopen (line, sizeof (line) - 1, "w");
+      print_parameters (fp, params);
+      fclose (fp);
+      line[strcspn (line, "\n")] = '\0';
+      if (strlen (line) >= sizeof (h->parameters)) {
+	fprintf (stderr, "%s: the parameters do not fit in the %d bytes of "
+		 "the header:\n  %s\n", file, (int) sizeof (h->parameters),
+		 line);
+	exit (1);
+      }
+      strcpy (h->parameters, line);
+    }
+
+    FILE * fp = fopen (file, "a");
+    if (!fp) {
+      perror (file);
+      exit (1);
+    }
+    setvbuf (fp, NULL, _IONBF, 0);
+    if (fwrite (frame, 1, size, fp) != size)
+      perror (file);
+    fclose (fp);
+  }
+  free (frame);
+}
@@ -0,0 +1,436 @@
+/**
+# Spectral solver for periodic domains
+
+On a periodic square domain, the implicit step of a
+reaction--diffusion equation with constant coefficients
+$$
+\frac{u^{n+1} - u^n}{\Delta t} = D\nabla^2 u^{n+1} - \sigma u^{n+1} +
+N(u^n)
+$$
+is diagonal in Fourier space
+$$
+\hat{u}^{n+1}_\mathbf{k} = \frac{\hat{u}^n_\mathbf{k}/\Delta t +
+\hat{N}_\mathbf{k}}{1/\Delta t + D|\mathbf{k}|^2 + \sigma}
+$$
+so that it is solved exactly, at the cost of a few real-to-complex
+FFTs, i.e. $O(N^2\log N)$ operations for an $N\times N$ grid, without
+any iteration or tolerance. The nonlinear terms $N(u^n)$ are evaluated
+pseudo-spectrally: products are computed on the grid and derivatives
+(gradients and divergences) in Fourier space.
+
+We use [FFTW](https://www.fftw.org) and need a uniform, periodic
+multigrid on a single process. With OpenMP, the transforms are
+multi-threaded. Only two dimensions are implemented.
+
+The nonlinear terms are not dealiased. Truncating their transforms
+after the products are formed on the grid would not help, since the
+aliased modes have then already folded into the retained band, and
+removing the aliasing of the cubic Brusselator kinetics would require
+grids padded twofold, on which the terms are not computed. The
+aliasing errors are small as long as the spectra of the fields have
+decayed well before the Nyquist wavenumber, i.e. the patterns must be
+resolved by the grid, as with the finite-volume schemes. */
+
+#if _MPI
+# error "spectral.h does not support MPI"
+#endif
+#if TREE
+# error "spectral.h requires a uniform (multi)grid"
+#endif
+#if MIXED_PRECISION
+# error "MIXED_PRECISION is not implemented for spectral.h"
+#endif
+
+#include <fftw3.h>
+#pragma autolink -lfftw3
+#if _OPENMP
+# pragma autolink -lfftw3_omp
+#endif
+
+static struct {
+  int n;
+  double * r;
+  fftw_complex * c[3];
+  fftw_plan forward, backward;
+} spectral = {0};
+
+/**
+The plans and buffers are created on first use and whenever the
+resolution changes. */
+
+static void spectral_setup (void)
+{
+  int n = 1 << depth();
+  if (spectral.n == n)
+    return;
+  if (spectral.n) {
+    fftw_destroy_plan (spectral.forward);
+    fftw_destroy_plan (spectral.backward);
+    fftw_free (spectral.r);
+    for (int k = 0; k < 3; k++)
+      fftw_free (spectral.c[k]);
+  }
+#if _OPENMP
+  static bool threads = false;
+  if (!threads) {
+    fftw_init_threads();
+    threads = true;
+  }
+  fftw_plan_with_nthreads (omp_get_max_threads());
+#endif
+  spectral.n = n;
+  spectral.r = fftw_alloc_real ((size_t) n*n);
+  for (int k = 0; k < 3; k++)
+    spectral.c[k] = fftw_alloc_complex ((size_t) n*(n/2 + 1));
+  spectral.forward = fftw_plan_dft_r2c_2d (n, n, spectral.r, spectral.c[0],
+					   FFTW_MEASURE);
+  spectral.backward = fftw_plan_dft_c2r_2d (n, n, spectral.c[0], spectral.r,
+					    FFTW_MEASURE);
+}
+
+/**
+The grid data is stored row by row, $y$ varying slowest, so that the
+first (resp. second) index of the transforms is the $y$ (resp. $x$)
+direction. The wavenumbers of mode `(j, i)` of the half-complex output
+are: */
+
+static inline double spectral_ky (int j)
+{
+  int n = spectral.n;
+  return 2.*pi/L0*(j <= n/2 ? j : j - n);
+}
+
+static inline double spectral_kx (int i)
+{
+  return 2.*pi/L0*i;
+}
+
+static void spectral_forward (scalar s, fftw_complex * out)
+{
+  int n = spectral.n;
+  double * r = spectral.r;
+  foreach() {
+    int i = (x - X0)/Delta, j = (y - Y0)/Delta;
+    r[j*n + i] = s[];
+  }
+  fftw_execute_dft_r2c (spectral.forward, r, out);
+}
+
+/**
+The backward transform destroys its input and is not normalised. */
+
+static void spectral_backward (fftw_complex * in, scalar s)
+{
+  int n = spectral.n;
+  double * r = spectral.r;
+  fftw_execute_dft_c2r (spectral.backward, in, r);
+  foreach() {
+    int i = (x - X0)/Delta, j = (y - Y0)/Delta;
+    s[] = r[j*n + i]/sq(n);
+  }
+}
+
+/**
+The derivative of a mode is its product with $\imath k$. The
+derivatives of the Nyquist modes are set to zero, so that derivatives
+of real fields remain real. */
+
+static void spectral_derivative (fftw_complex * in, fftw_complex * out,
+				 int dir, bool add)
+{
+  int n = spectral.n, m = n/2 + 1;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++) {
+      double k = dir == 0 ?
+	(i == n/2 ? 0. : spectral_kx (i)) :
+	(j == n/2 ? 0. : spectral_ky (j));
+      double re = - k*in[j*m + i][1], im = k*in[j*m + i][0];
+      if (add)
+	out[j*m + i][0] += re, out[j*m + i][1] += im;
+      else
+	out[j*m + i][0] = re, out[j*m + i][1] = im;
+    }
+}
+
+/**
+## User interface
+
+### spectral_solve()
+
+Advances `u` by one implicit step of size `dt` of
+$\partial_t u = D\nabla^2 u - \sigma u + N$, where the explicit term
+$N$ is given in field `s`. */
+
+void spectral_solve (scalar u, scalar s, double dt, double D, double sigma)
+{
+  spectral_setup();
+  fftw_complex * uh = spectral.c[0], * sh = spectral.c[1];
+  spectral_forward (u, uh);
+  spectral_forward (s, sh);
+  int n = spectral.n, m = n/2 + 1;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++) {
+      double kx = spectral_kx (i), ky = spectral_ky (j);
+      double a = 1./(1./dt + D*(sq(kx) + sq(ky)) + sigma);
+      for (int c = 0; c < 2; c++)
+	uh[j*m + i][c] = a*(uh[j*m + i][c]/dt + sh[j*m + i][c]);
+    }
+  spectral_backward (uh, u);
+}
+
+/**
+### spectral_gradient()
+
+Computes the (cell-centered) gradient `g` of `s`. */
+
+void spectral_gradient (scalar s, vector g)
+{
+  spectral_setup();
+  fftw_complex * sh = spectral.c[0], * gh = spectral.c[1];
+  spectral_forward (s, sh);
+  spectral_derivative (sh, gh, 0, false);
+  spectral_backward (gh, g.x);
+  spectral_derivative (sh, gh, 1, false);
+  spectral_backward (gh, g.y);
+}
+
+/**
+### spectral_divergence()
+
+Computes the divergence `div` of the cell-centered vector field `f`. */
+
+void spectral_divergence (vector f, scalar div)
+{
+  spectral_setup();
+  fftw_complex * fh = spectral.c[0], * dh = spectral.c[2];
+  spectral_forward (f.x, fh);
+  spectral_derivative (fh, dh, 0, false);
+  spectral_forward (f.y, fh);
+  spectral_derivative (fh, dh, 1, true);
+  spectral_backward (dh, div);
+}
+
+/**
+## Exponential time differencing
+
+With the linear part $L = -D|\mathbf{k}|^2 - \sigma$ diagonal in
+Fourier space, the stiff diffusion can be integrated exactly, and only
+the nonlinear terms $N(u)$ need to be approximated. The fourth-order
+scheme ETDRK4 of [Cox and Matthews,
+2002](https://doi.org/10.1006/jcph.2002.6995) advances
+$\partial_t u = Lu + N(u)$ by $h$ with
+$$
+\begin{aligned}
+a &= e^{Lh/2}u^n + Q\,N(u^n), \qquad
+b = e^{Lh/2}u^n + Q\,N(a), \\
+c &= e^{Lh/2}a + Q\,(2N(b) - N(u^n)), \\
+u^{n+1} &= e^{Lh}u^n + f_1 N(u^n) + 2 f_2 (N(a) + N(b)) + f_3 N(c)
+\end{aligned}
+$$
+mode by mode, with $Q = \frac{h}{2}\varphi_1(Lh/2)$ and, for $z = Lh$,
+$$
+f_1 = h(\varphi_1 - 3\varphi_2 + 4\varphi_3),\quad
+f_2 = h(\varphi_2 - 2\varphi_3),\quad
+f_3 = h(4\varphi_3 - \varphi_2)
+$$
+where $\varphi_1(z) = (e^z - 1)/z$ and $\varphi_{k+1}(z) = (\varphi_k(z)
+- 1/k!)/z$. Evaluated directly, these expressions suffer from
+cancellation errors for small $|z|$, which [Kassam and Trefethen,
+2005](https://doi.org/10.1137/S1064827502410633) avoid with contour
+integrals. Since $z$ is real here, we use the Taylor series
+$\varphi_k(z) = \sum_j z^j/(j + k)!$ for $|z| < 1$ instead. */
+
+static void spectral_phi (double z, double phi[3])
+{
+  if (fabs (z) < 1.) {
+    for (int k = 1; k <= 3; k++) {
+      double term = 1., sum = 0.;
+      for (int j = 2; j <= k; j++)
+	term /= j;
+      for (int j = 0; j < 20; j++) {
+	sum += term;
+	term *= z/(j + k + 1);
+      }
+      phi[k - 1] = sum;
+    }
+  }
+  else {
+    phi[0] = expm1 (z)/z;
+    phi[1] = (phi[0] - 1.)/z;
+    phi[2] = (phi[1] - 0.5)/z;
+  }
+}
+
+/**
+The coefficients of each field only depend on $|\mathbf{k}|^2$, $h$,
+$D$ and $\sigma$, and cost many more operations than a step. They are
+kept in `SPECTRAL_ETD_SETS` sets per field keyed by $h$, $D$ and
+$\sigma$, the least recently used set being recomputed for a new
+timestep. Each field also keeps the transforms of the stages. Two sets
+hold both the full step $h$ and the half steps $h/2$ of the [timestep
+controller](dtcontrol.h), which alternate at every step. */
+
+#define SPECTRAL_FIELDS 4
+#define SPECTRAL_ETD_SETS 2
+
+enum { ETD_E, ETD_E2, ETD_Q, ETD_F1, ETD_F2, ETD_F3 };
+
+typedef struct {
+  double h, D, sigma;
+  long used;
+  double * c[6];
+} SpectralETDSet;
+
+static struct {
+  int n;
+  long calls;
+  SpectralETDSet set[SPECTRAL_ETD_SETS];
+  fftw_complex * u, * nu, * na, * nb;
+} spectral_etd[SPECTRAL_FIELDS];
+
+static double ** spectral_etd_setup (int f, double h, double D, double sigma)
+{
+  int n = spectral.n, m = n/2 + 1;
+  if (spectral_etd[f].n != n) {
+    for (int s = 0; s < SPECTRAL_ETD_SETS; s++) {
+      SpectralETDSet * set = &spectral_etd[f].set[s];
+      for (int k = 0; k < 6; k++) {
+	if (spectral_etd[f].n)
+	  fftw_free (set->c[k]);
+	set->c[k] = fftw_alloc_real ((size_t) n*m);
+      }
+      set->h = 0., set->used = 0;
+    }
+    if (spectral_etd[f].n) {
+      fftw_free (spectral_etd[f].u), fftw_free (spectral_etd[f].nu);
+      fftw_free (spectral_etd[f].na), fftw_free (spectral_etd[f].nb);
+    }
+    spectral_etd[f].u = fftw_alloc_complex ((size_t) n*m);
+    spectral_etd[f].nu = fftw_alloc_complex ((size_t) n*m);
+    spectral_etd[f].na = fftw_alloc_complex ((size_t) n*m);
+    spectral_etd[f].nb = fftw_alloc_complex ((size_t) n*m);
+    spectral_etd[f].n = n;
+  }
+
+  SpectralETDSet * set = &spectral_etd[f].set[0];
+  for (int s = 0; s < SPECTRAL_ETD_SETS; s++) {
+    SpectralETDSet * p = &spectral_etd[f].set[s];
+    if (p->h == h && p->D == D && p->sigma == sigma) {
+      p->used = ++spectral_etd[f].calls;
+      return p->c;
+    }
+    if (p->used < set->used)
+      set = p;
+  }
+  set->h = h, set->D = D, set->sigma = sigma;
+  set->used = ++spectral_etd[f].calls;
+  double ** c = set->c;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++) {
+      int k = j*m + i;
+      double z = - h*(D*(sq(spectral_kx (i)) + sq(spectral_ky (j))) + sigma);
+      double phi[3];
+      spectral_phi (z/2., phi);
+      c[ETD_E][k] = exp (z);
+      c[ETD_E2][k] = exp (z/2.);
+      c[ETD_Q][k] = h/2.*phi[0];
+      spectral_phi (z, phi);
+      c[ETD_F1][k] = h*(phi[0] - 3.*phi[1] + 4.*phi[2]);
+      c[ETD_F2][k] = h*(phi[1] - 2.*phi[2]);
+      c[ETD_F3][k] = h*(4.*phi[2] - phi[1]);
+    }
+  return c;
+}
+
+/**
+### spectral_etdrk4()
+
+Advances the fields of `list` by one ETDRK4 step of size `dt` of
+$\partial_t u = D\nabla^2 u - \sigma u + N(u)$, with coefficients
+`D[]` and `sigma[]` for each field. The function `rhs` computes the
+nonlinear terms $N$ of all the fields of its first list into the fields
+of its second list, here `nl`. It is called four times per step, on
+the stages $u^n$, $a$, $b$ and $c$, which are stored in the fields of
+`list`. */
+
+typedef void (* SpectralRHS) (scalar * list, scalar * nl);
+
+void spectral_etdrk4 (scalar * list, scalar * nl, double dt,
+		      const double * D, const double * sigma, SpectralRHS rhs)
+{
+  spectral_setup();
+  int nf = list_len (list), n = spectral.n, m = n/2 + 1;
+  assert (nf <= SPECTRAL_FIELDS && list_len (nl) == nf);
+  double ** coef[nf];
+  for (int f = 0; f < nf; f++)
+    coef[f] = spectral_etd_setup (f, dt, D[f], sigma[f]);
+  fftw_complex * tmp = spectral.c[0], * nc = spectral.c[1];
+
+  rhs (list, nl);
+  for (int f = 0; f < nf; f++) {
+    spectral_forward (list[f], spectral_etd[f].u);
+    spectral_forward (nl[f], spectral_etd[f].nu);
+  }
+
+  /**
+  Stage $a$. */
+
+  for (int f = 0; f < nf; f++) {
+    double ** c = coef[f];
+    fftw_complex * u = spectral_etd[f].u, * nu = spectral_etd[f].nu;
+    for (int k = 0; k < n*m; k++)
+      for (int r = 0; r < 2; r++)
+	tmp[k][r] = c[ETD_E2][k]*u[k][r] + c[ETD_Q][k]*nu[k][r];
+    spectral_backward (tmp, list[f]);
+  }
+  rhs (list, nl);
+  for (int f = 0; f < nf; f++)
+    spectral_forward (nl[f], spectral_etd[f].na);
+
+  /**
+  Stage $b$. */
+
+  for (int f = 0; f < nf; f++) {
+    double ** c = coef[f];
+    fftw_complex * u = spectral_etd[f].u, * na = spectral_etd[f].na;
+    for (int k = 0; k < n*m; k++)
+      for (int r = 0; r < 2; r++)
+	tmp[k][r] = c[ETD_E2][k]*u[k][r] + c[ETD_Q][k]*na[k][r];
+    spectral_backward (tmp, list[f]);
+  }
+  rhs (list, nl);
+  for (int f = 0; f < nf; f++)
+    spectral_forward (nl[f], spectral_etd[f].nb);
+
+  /**
+  Stage $c$, with $a$ computed again rather than stored. */
+
+  for (int f = 0; f < nf; f++) {
+    double ** c = coef[f];
+    fftw_complex * u = spectral_etd[f].u, * nu = spectral_etd[f].nu;
+    fftw_complex * nb = spectral_etd[f].nb;
+    for (int k = 0; k < n*m; k++)
+      for (int r = 0; r < 2; r++) {
+	double a = c[ETD_E2][k]*u[k][r] + c[ETD_Q][k]*nu[k][r];
+	tmp[k][r] = c[ETD_E2][k]*a + c[ETD_Q][k]*(2.*nb[k][r] - nu[k][r]);
+      }
+    spectral_backward (tmp, list[f]);
+  }
+  rhs (list, nl);
+
+  /**
+  The new state. */
+
+  for (int f = 0; f < nf; f++) {
+    spectral_forward (nl[f], nc);
+    double ** c = coef[f];
+    fftw_complex * u = spectral_etd[f].u, * nu = spectral_etd[f].nu;
+    fftw_complex * na = spectral_etd[f].na, * nb = spectral_etd[f].nb;
+    for (int k = 0; k < n*m; k++)
+      for (int r = 0; r < 2; r++)
+	tmp[k][r] = (c[ETD_E][k]*u[k][r] + c[ETD_F1][k]*nu[k][r] +
+		     2.*c[ETD_F2][k]*(na[k][r] + nb[k][r]) +
+		     c[ETD_F3][k]*nc[k][r]);
+    spectral_backward (tmp, list[f]);
+  }
+}
@@ -0,0 +1,160 @@
+/**
+# Steady-state detection
+
+Many runs reach a stationary pattern long before their final time.
+This monitor measures, every `steady_every` iterations,
+
+* the rate of change of a field $f$ since the previous check,
+  relative to the amplitude of its pattern
+  $$
+  r = \frac{\|f(t) - f(t')\|_\infty}{(t - t')\,\|f(t) - \bar{f}\|_\infty}
+  $$
+  i.e. $\|f^{n+1} - f^n\|/\Delta t$ averaged over the interval. The
+  amplitude excludes the mean $\bar{f}$, which would otherwise dominate
+  while the pattern is small: a pattern of amplitude $A$ growing as
+  $e^{\sigma t}$ has $r \ge \sigma$ however small $A$ is, so that a
+  pattern which has not saturated is not taken for a steady one, and
+  a homogeneous field ($A = 0$) never is,
+* the dominant wavenumber of the pattern, estimated without Fourier
+  transform as the spectral centroid
+  $$
+  q = \left(\frac{\int |\nabla f|^2}{\int (f - \bar{f})^2}\right)^{1/2}
+  = \left(\frac{\sum_\mathbf{k} |\mathbf{k}|^2|\hat{f}_\mathbf{k}|^2}
+  {\sum_{\mathbf{k}\neq 0} |\hat{f}_\mathbf{k}|^2}\right)^{1/2}
+  $$
+  (Parseval), which is the wavenumber of the spectral peak for a
+  pattern of a single wavelength, and its relative rate of change
+  $|q(t) - q(t')|/((t - t')\,q)$.
+
+The state is considered stationary when both rates are below
+`steady_tol` for `steady_window` consecutive checks. The settling time
+is the time of the first of these checks. It is logged on standard
+error and appended, with the time of detection and the parameters of
+the run, to `steady.csv`.
+
+The integrals and norms are computed by the case, within a sweep over
+the grid which it does anyway (e.g. for its
+[diagnostics](diagnostics.h)), where it also keeps a copy of $f$ for
+the next check:
+
+~~~literatec
+scalar C1prev[];
+
+event monitor (i++)
+{
+  ...
+  foreach (reduction(max:diff) ...) {
+    ...
+    if (check) {
+      diff = max (diff, fabs (C1[] - C1prev[]));
+      C1prev[] = C1[];
+    }
+  }
+  if (check &&
+      steady_check (diff, steady_amplitude (vol, sum, fmin, fmax),
+		    steady_wavenumber (vol, sum, sum2, grad), params)) {
+    final_outputs();
+    return 1;
+  }
+}
+~~~
+
+with `check = steady_due()`. A zero (default) tolerance disables the
+detection. */
+
+#include "parameters.h"
+
+double steady_tol = 0.;
+int steady_every = 10, steady_window = 10;
+
+static struct {
+  double t, q, settled;
+  int count;
+} steady;
+
+/**
+### steady_due()
+
+Whether the state must be checked at this iteration. */
+
+bool steady_due (void)
+{
+  return steady_tol > 0. && i % steady_every == 0;
+}
+
+/**
+### steady_amplitude()
+
+The amplitude $\|f - \bar{f}\|_\infty$ of the pattern of a field from
+the volume `vol` of the domain, the integral `sum` of $f$ and its
+extrema. */
+
+double steady_amplitude (double vol, double sum, double fmin, double fmax)
+{
+  double mean = sum/vol;
+  return max (fmax - mean, mean - fmin);
+}
+
+/**
+### steady_wavenumber()
+
+The spectral centroid of a field from the volume `vol` of the domain
+and the integrals `sum` of $f$, `sum2` of $f^2$ and `grad` of
+$|\nabla f|^2$. */
+
+double steady_wavenumber (double vol, double sum, double sum2, double grad)
+{
+  double var = sum2/vol - sq(sum/vol);
+  return var > 0. ? sqrt (grad/var/vol) : 0.;
+}
+
+/**
+The monitor restarts with each run (and after a restart from a
+checkpoint, since the previous field is not saved). */
+
+event steady_reset (i = 0)
+{
+  steady.t = - 1., steady.count = 0;
+}
+
+/**
+### steady_check()
+
+Returns `true` when the field has become stationary, given the
+maximum `diff` of its change since the previous check, the amplitude
+`amp` of its pattern (see `steady_amplitude()`) and its wavenumber
+`q`. */
+
+bool steady_check (double diff, double amp, double q, Parameter * params)
+{
+  if (steady.t >= 0. && t > steady.t) {
+    double rate = amp > 0. ? diff/(amp*(t - steady.t)) : HUGE;
+    double qrate = q > 0. ? fabs (q - steady.q)/(q*(t - steady.t)) : 0.;
+    if (rate < steady_tol && qrate < steady_tol) {
+      if (steady.count++ == 0)
+	steady.settled = steady.t;
+    }
+    else
+      steady.count = 0;
+  }
+  steady.t = t, steady.q = q;
+
+  if (steady.count < steady_window)
+    return false;
+
+  if (pid() == 0) {
+    fprintf (stderr, "steady: stationary since t = %g (detected at t = %g, "
+	     "i = %d, q = %g)\n", steady.settled, t, i, q);
+    FILE * fp = fopen ("steady.csv", "a");
+    if (!fp) {
+      perror ("steady.csv");
+      exit (1);
+    }
+    if (ftell (fp) == 0)
+      fputs ("t_settled,t,i,q,parameters\n", fp);
+    fprintf (fp, "%g,%g,%d,%g,", steady.settled, t, i, q);
+    print_parameters (fp, params);
+    fclose (fp);
+  }
+  return true;
+}
@@ -0,0 +1,78 @@
+/**
+# Tolerance scheduling for the implicit solves
+
+The multigrid solves converge to a fixed residual `TOLERANCE`, whether
+the pattern is in fast transient growth or frozen, and whatever the
+error made by the time discretisation (first order, with split
+species) at the same step. Here, the tolerance of each solve is
+instead chosen from an estimate of this error.
+
+The estimate is that of a predictor--corrector pair: with the
+[warm start](warmstart.h), the predictor is the extrapolation $f^*$ of
+the two previous steps and the corrector is the implicit step
+$f^{n+1}$. Both are exact to first order, so that their difference is
+of the order of the local error of the step, $O(\Delta t^2 f'')$. The
+solver reports it, in residual units, as the residual $r^*$ of the
+predictor (`resb`), and the implicit operator (dominated by
+$-1/\Delta t$) turns a residual $r$ into an error in $f$ of at most
+$r\,\Delta t$. The local time error is thus estimated as
+$$
+e = r^*\,\Delta t
+$$
+and the error left by the solver, at most $\tau\,\Delta t$ for a
+tolerance $\tau$, is kept to a fraction `tolsched_factor` of it with
+the tolerance of the next solve
+$$
+\tau = \text{tolsched\_factor}\;r^*
+$$
+bounded by `tolsched_min` and `tolsched_max`. There is no point in
+converging the solver to $10^{-4}$ when the time error is $10^{-2}$,
+while the tolerance tightens as the pattern freezes (if a fixed
+accuracy in time is required, see the [timestep
+controller](dtcontrol.h)).
+
+The first solve of each field in a run, without an estimate, uses
+`TOLERANCE`, as do all the solves when the warm start is disabled.
+Every solve is logged to `tolerance.csv`, with its time error
+estimate, the tolerance used and the number of cycles, so that the
+accuracy of a run can be audited afterwards. A zero (default)
+`tolsched_factor` disables the schedule. */
+
+double tolsched_factor = 0., tolsched_min = 1e-8, tolsched_max = 1e-2;
+
+/**
+### tolsched_tolerance()
+
+The tolerance of the next solve of a field, given the residual `resb`
+of the predictor at its previous solve (zero without estimate). */
+
+double tolsched_tolerance (double resb)
+{
+  if (tolsched_factor <= 0. || resb <= 0.)
+    return TOLERANCE;
+  return min (tolsched_max, max (tolsched_min, tolsched_factor*resb));
+}
+
+/**
+### tolsched_log()
+
+Appends the solve of field `name` with timestep `dt`, tolerance `tol`
+and statistics `s` to `tolerance.csv`. */
+
+void tolsched_log (const char * name, double dt, double tol, mgstats s)
+{
+  if (tolsched_factor <= 0. || pid() > 0)
+    return;
+  static FILE * fp = NULL;
+  if (!fp) {
+    fp = fopen ("tolerance.csv", "a");
+    if (!fp) {
+      perror ("tolerance.csv");
+      exit (1);
+    }
+    if (ftell (fp) == 0)
+      fputs ("t,i,field,dt,error,tolerance,cycles,resa\n", fp);
+  }
+  fprintf (fp, "%g,%d,%s,%g,%g,%g,%d,%g\n", t, i, name, dt, s.resb*dt, tol,
+	   s.i, s.resa);
+}
@@ -0,0 +1,151 @@
+/**
+# Warm-started implicit solves
+
+The multigrid iterations of an implicit step start from the current
+field $f^n$. Near a slowly evolving pattern, the solution $f^{n+1}$ is
+much better predicted by the linear extrapolation of the two previous
+steps
+$$
+f^* = f^n + \frac{\Delta t_n}{\Delta t_{n-1}}\,(f^n - f^{n-1})
+$$
+whose error is second order in $\Delta t$ instead of first order. The
+solver then starts closer to the solution and needs fewer V-cycles,
+ideally one per step (the minimum done by the solver). The converged
+solution is the same, up to the tolerance, whatever the guess.
+
+A case keeps the previous state of each field in a field of its own,
+wraps the solve of the field in a function, and calls
+`warmstart_solve()` instead:
+
+~~~literatec
+scalar C1old[];
+WarmStart warm1 = {"C1"};
+
+static mgstats solve1 (scalar a)
+{
+  return poisson (a, rhs1, lambda = lambda1, res = {resid});
+}
+...
+mgd1 = warmstart_solve (C1, C1old, dt, solve1, &warm1);
+~~~
+
+The right-hand side and coefficients must be assembled (from $f^n$)
+before the call, since the field is then overwritten by the guess.
+
+To measure the cycles saved, one solve every `warmstart_sample` is
+also done from the cold start $f^n$ (in a scratch copy of the field,
+which is then discarded). At the end of each run, the mean number of
+cycles per solve, the fraction of solves done in a single cycle and
+the mean number of cycles of the sampled cold starts are printed on
+standard error, for each field.
+
+The extrapolation is disabled with `warmstart = 0`; it restarts with
+each run (and after a restart from a checkpoint). When the steps of
+the [timestep controller](dtcontrol.h) are taken from a saved state,
+the guess is only approximate for the first solve after each change
+of starting state, which costs cycles but not accuracy.
+
+The residual of the extrapolated guess also estimates the time error of
+the step, from which the tolerance of the next solve can be scheduled
+(see [tolsched.h](tolsched.h)). */
+
+#include "tolsched.h"
+
+int warmstart = 1, warmstart_sample = 100;
+
+typedef struct {
+  const char * name;
+  double dt, resb, tol;
+  long solves, cycles, single, sampled, cold, warm;
+  bool registered;
+} WarmStart;
+
+static WarmStart * warmstart_list[8];
+static int warmstart_n = 0;
+
+/**
+### warmstart_solve()
+
+Solves for `a` with `solve`, starting from the extrapolation of `a`
+and its previous value `prev` for the timestep `dt`, and updates the
+statistics `w`. Returns the statistics of the solve. */
+
+mgstats warmstart_solve (scalar a, scalar prev, double dt,
+			 mgstats (* solve) (scalar a), WarmStart * w)
+{
+  if (!w->registered) {
+    assert (warmstart_n < 8);
+    warmstart_list[warmstart_n++] = w;
+    w->registered = true;
+  }
+
+  bool history = warmstart && w->dt > 0.;
+  double tol = tolsched_tolerance (w->resb), defaultol = TOLERANCE;
+  TOLERANCE = tol;
+  if (history && warmstart_sample > 0 &&
+      w->solves % warmstart_sample == 0) {
+    scalar * l = list_clone ({a});
+    scalar scratch = l[0];
+    foreach()
+      scratch[] = a[];
+    w->cold += solve (scratch).i;
+    w->sampled++;
+    delete (l);
+    free (l);
+  }
+
+  if (warmstart) {
+    double r = history ? dt/w->dt : 0.;
+    foreach() {
+      double f = a[];
+      a[] = f + r*(f - prev[]);
+      prev[] = f;
+    }
+  }
+  w->dt = dt;
+
+  mgstats s = solve (a);
+  TOLERANCE = defaultol;
+  tolsched_log (w->name, dt, tol, s);
+  w->resb = history ? s.resb : 0.;
+  w->tol += tol;
+  w->solves++;
+  w->cycles += s.i;
+  if (s.i <= 1)
+    w->single++;
+  if (history && warmstart_sample > 0 &&
+      (w->solves - 1) % warmstart_sample == 0)
+    w->warm += s.i;
+  return s;
+}
+
+event warmstart_reset (i = 0)
+{
+  for (int k = 0; k < warmstart_n; k++) {
+    WarmStart * w = warmstart_list[k];
+    w->dt = w->resb = w->tol = 0.;
+    w->solves = w->cycles = w->single = w->sampled = w->cold = w->warm = 0;
+  }
+}
+
+event warmstart_summary (t = end)
+{
+  if (pid() > 0)
+    return 0;
+  for (int k = 0; k < warmstart_n; k++) {
+    WarmStart * w = warmstart_list[k];
+    if (!w->solves)
+      continue;
+    fprintf (stderr, "warmstart: %s: %.2f cycles/solve, %.0f%% in one cycle",
+	     w->name, w->cycles/(double) w->solves,
+	     100.*w->single/w->solves);
+    if (tolsched_factor > 0.)
+      fprintf (stderr, ", mean tolerance %g", w->tol/w->solves);
+    if (w->sampled)
+      fprintf (stderr, "; sampled cold starts %.2f vs %.2f cycles/solve, "
+	       "about %.0f cycles saved in total",
+	       w->cold/(double) w->sampled, w->warm/(double) w->sampled,
+	       (w->cold - w->warm)*w->solves/(double) w->sampled);
+    fputc ('\n', stderr);
+  }
+}